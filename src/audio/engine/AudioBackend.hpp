@@ -0,0 +1,46 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+class AudioEngine;
+
+struct AudioDeviceInfo {
+  int index;
+  std::string name;
+  int maxInputChannels;
+  int maxOutputChannels;
+  double defaultSampleRate;
+};
+
+struct AudioConfig {
+  double sampleRate = 44100.0;
+  unsigned long framesPerBuffer = 512;
+  // Samples the processors get per call whatever the device's buffers, 0
+  // to pass those through. Adds a block of latency unless it divides them.
+  unsigned long blockSize = 0;
+  // Ask the devices for their low latency instead of their high one, and
+  // fail rather than fall back to larger buffers
+  bool lowLatency = false;
+  int inputDevice = -1; // Index from listDevices, -1 for the default device
+  int outputDevice = -1;
+};
+
+// Buffer problems a device reports along with a callback, as a bit mask
+enum AudioXrun : unsigned {
+  XRUN_INPUT_UNDERFLOW = 1 << 0,
+  XRUN_INPUT_OVERFLOW = 1 << 1,
+  XRUN_OUTPUT_UNDERFLOW = 1 << 2,
+  XRUN_OUTPUT_OVERFLOW = 1 << 3,
+};
+
+// Where the audio thread comes from. A backend calls
+// AudioEngine::audioCallback once per buffer from its own thread between
+// start and stop.
+class AudioBackend {
+public:
+  virtual ~AudioBackend() = default;
+  virtual std::vector<AudioDeviceInfo> listDevices() = 0;
+  virtual void start(AudioEngine *engine, const AudioConfig &config) = 0;
+  virtual void stop() = 0;
+};
@@ -1,182 +1,154 @@
 #include "AudioEngine.hpp"
-#include <cmath>
-#include <iostream>
-#include <portaudio.h>
+#include "Kernels.hpp"
+#include "PortAudioBackend.hpp"
+#include "RealtimeGuard.hpp"
+#include "../../core/Trace.hpp"
+#include <algorithm>
 #include <stdexcept>
+#include <string>
 
 AudioEngine::AudioEngine(Processor *proc, int inputChannelStart)
-    : processor(proc), stream(nullptr), inputChannelStart(inputChannelStart) {
-  PaError err = Pa_Initialize();
-  if (err != paNoError) {
-    throw std::runtime_error("Failed to initialize PortAudio");
-  }
-  this->phase = 0;
-}
-
-AudioEngine::~AudioEngine() { Pa_Terminate(); }
-
-void AudioEngine::start() {
-  if (this->stream) {
-    this->stop();
-  }
+    : AudioEngine(proc, new PortAudioBackend(inputChannelStart)) {}
 
-  PaStreamParameters inputParameters;
-  inputParameters.device = Pa_GetDefaultInputDevice();
-  if (inputParameters.device == paNoDevice) {
-    throw std::runtime_error("No default input device found");
-  }
+AudioEngine::AudioEngine(Processor *proc, AudioBackend *backend)
+    : backend(backend), processor(proc) {}
 
-  // Set the correct input channels (2 channels starting at inputChannelStart)
-  inputParameters.channelCount = 2;
-  inputParameters.sampleFormat = paFloat32 | paNonInterleaved;
+AudioEngine::~AudioEngine() {
+  stop();
+  delete backend;
+}
 
-  // Get device info to adjust parameters based on actual capabilities
-  const PaDeviceInfo *deviceInfo = Pa_GetDeviceInfo(inputParameters.device);
-  if (!deviceInfo) {
-    throw std::runtime_error("Failed to get device info");
+void AudioEngine::start() {
+  this->stop();
+  // Prepare processor before opening stream. The PortAudio fallback may
+  // open larger buffers than configured, so size everything for the largest.
+  {
+    BufferArena::Use use(arena);
+    if (config.blockSize) {
+      this->processor->prepare(config.sampleRate, channels, config.blockSize);
+      blocks.prepare(channels, config.blockSize, config.framesPerBuffer);
+    } else {
+      this->processor->prepare(config.sampleRate, channels,
+                               MAX_FRAMES_PER_BUFFER);
+    }
   }
-
-  // Check if the requested channels are available
-  if (inputChannelStart + 2 > deviceInfo->maxInputChannels) {
-    std::cerr << "Warning: Device only has " << deviceInfo->maxInputChannels
-              << " input channels, but channels " << inputChannelStart << "-"
-              << (inputChannelStart + 1) << " were requested." << std::endl;
-
-    // Fall back to default channels if requested ones are not available
-    inputChannelStart = 0;
-    std::cerr << "Falling back to channels 0-1" << std::endl;
+  for (auto &buffer : silence) {
+    buffer.assign(MAX_FRAMES_PER_BUFFER, 0.0f);
   }
-
-  std::cout << "Using input channels " << inputChannelStart << "-"
-            << (inputChannelStart + 1) << std::endl;
-
-  inputParameters.suggestedLatency =
-      Pa_GetDeviceInfo(inputParameters.device)->defaultHighInputLatency;
-  inputParameters.hostApiSpecificStreamInfo = nullptr;
-
-  // Setup output parameters
-  PaStreamParameters outputParameters;
-  outputParameters.device = Pa_GetDefaultOutputDevice();
-  if (outputParameters.device == paNoDevice) {
-    throw std::runtime_error("No default output device found");
+  for (auto &count : xruns) {
+    count = 0;
   }
-  outputParameters.channelCount = 2;
-  outputParameters.sampleFormat = paFloat32 | paNonInterleaved;
-
-  // Increase output latency significantly
-  outputParameters.suggestedLatency =
-      Pa_GetDeviceInfo(outputParameters.device)->defaultHighOutputLatency;
-  // Or set an explicit high value:
-  // outputParameters.suggestedLatency = 0.1; // 100ms latency
-
-  outputParameters.hostApiSpecificStreamInfo = nullptr;
-
-  // Use a larger buffer size as well
-  unsigned long framesPerBuffer = 512; // Increased from 64 to 512
-
-  double sampleRate = 44100;
-
-  // Prepare processor before opening stream
-  this->processor->prepare(sampleRate, 2);
-
-  std::cout << "Opening stream with input latency: "
-            << inputParameters.suggestedLatency
-            << "s, output latency: " << outputParameters.suggestedLatency
-            << "s, buffer size: " << framesPerBuffer << std::endl;
+  backend->start(this, config);
+  running = true;
+}
 
-  // Open stream with both input and output
-  PaError err =
-      Pa_OpenStream(&stream, &inputParameters, &outputParameters, sampleRate,
-                    framesPerBuffer, paClipOff, audioCallback, this);
+void AudioEngine::stop() {
+  backend->stop();
+  running = false;
+  RealtimeGuard::report();
+}
 
-  if (err != paNoError) {
-    std::cerr << "Failed to open stream: " << Pa_GetErrorText(err) << std::endl;
+bool AudioEngine::isRunning() const { return running; }
 
-    // Fallback: try with even higher latency and larger buffer
-    inputParameters.suggestedLatency = 0.2;  // 200ms
-    outputParameters.suggestedLatency = 0.2; // 200ms
-    unsigned long fallbackFramesPerBuffer = 1024;
+Processor *AudioEngine::getProcessor() { return processor; }
 
-    std::cout << "Trying fallback with higher latency (200ms) and larger "
-                 "buffer (1024)"
-              << std::endl;
+AudioBackend *AudioEngine::getBackend() { return backend; }
 
-    err =
-        Pa_OpenStream(&stream, &inputParameters, &outputParameters, sampleRate,
-                      fallbackFramesPerBuffer, paClipOff, audioCallback, this);
+vector<AudioDeviceInfo> AudioEngine::listDevices() {
+  return backend->listDevices();
+}
 
-    if (err != paNoError) {
-      // Last resort: try output-only
-      std::cout << "Trying output-only stream as last resort" << std::endl;
-      err = Pa_OpenStream(&stream, nullptr, &outputParameters, sampleRate,
-                          fallbackFramesPerBuffer, paClipOff, audioCallback,
-                          this);
+const vector<double> &AudioEngine::getSupportedSampleRates() {
+  static const vector<double> rates = {44100.0, 48000.0, 88200.0, 96000.0};
+  return rates;
+}
 
-      if (err != paNoError) {
-        throw std::runtime_error("Failed to open stream with PortAudio: " +
-                                 std::string(Pa_GetErrorText(err)));
-      }
-    }
+void AudioEngine::setConfig(const AudioConfig &newConfig) {
+  const vector<double> &rates = getSupportedSampleRates();
+  if (std::find(rates.begin(), rates.end(), newConfig.sampleRate) ==
+      rates.end()) {
+    throw std::runtime_error("Unsupported sample rate " +
+                             std::to_string(newConfig.sampleRate));
   }
-
-  err = Pa_StartStream(stream);
-  if (err != paNoError) {
-    std::cerr << "Failed to start stream: " << Pa_GetErrorText(err)
-              << std::endl;
-    Pa_CloseStream(stream);
-    throw std::runtime_error("Failed to start PortAudio stream: " +
-                             std::string(Pa_GetErrorText(err)));
+  if (newConfig.framesPerBuffer < MIN_FRAMES_PER_BUFFER ||
+      newConfig.framesPerBuffer > MAX_FRAMES_PER_BUFFER) {
+    throw std::runtime_error("Unsupported buffer size " +
+                             std::to_string(newConfig.framesPerBuffer));
   }
-
-  const PaStreamInfo *streamInfo = Pa_GetStreamInfo(stream);
-  if (streamInfo) {
-    std::cout << "Stream successfully started with:"
-              << "\n  - Input latency: " << streamInfo->inputLatency << "s"
-              << "\n  - Output latency: " << streamInfo->outputLatency << "s"
-              << "\n  - Sample rate: " << streamInfo->sampleRate << "Hz"
-              << std::endl;
-  } else {
-    std::cout << "Stream started but couldn't get stream info" << std::endl;
+  if (newConfig.blockSize != 0 &&
+      (newConfig.blockSize < MIN_FRAMES_PER_BUFFER ||
+       newConfig.blockSize > MAX_FRAMES_PER_BUFFER)) {
+    throw std::runtime_error("Unsupported block size " +
+                             std::to_string(newConfig.blockSize));
   }
-}
-
-void AudioEngine::stop() {
-  if (this->stream) {
-    Pa_StopStream(this->stream);
-    Pa_CloseStream(this->stream);
-    this->stream = nullptr;
+  bool wasRunning = running;
+  stop();
+  config = newConfig;
+  if (wasRunning) {
+    start();
   }
 }
 
-Processor *AudioEngine::getProcessor() { return processor; }
+const AudioConfig &AudioEngine::getConfig() const { return config; }
 
-int AudioEngine::audioCallback(const void *inputBuffer, void *outputBuffer,
-                               unsigned long framesPerBuffer,
-                               const PaStreamCallbackTimeInfo *timeInfo,
-                               PaStreamCallbackFlags flags, void *userData) {
-  AudioEngine *engine = static_cast<AudioEngine *>(userData);
-  float **out = (float **)outputBuffer;
-  float **in = (float **)inputBuffer;
-
-  // Create a zero-filled buffer if input is null
-  float *tempBuffers[2] = {nullptr, nullptr};
-  float **actualInput = in;
-
-  if (in == nullptr) {
-    // Create temporary buffers for input if none provided
-    tempBuffers[0] = new float[framesPerBuffer](); // Initialize to zero
-    tempBuffers[1] = new float[framesPerBuffer]();
-    actualInput = tempBuffers;
-  }
+unsigned long AudioEngine::getBlockLatency() const {
+  return config.blockSize ? blocks.getLatency() : 0;
+}
 
-  // Process audio
-  engine->processor->process(actualInput, out, framesPerBuffer);
+LoadMeter &AudioEngine::getLoad() { return load; }
 
-  // Clean up temporary buffers if created
-  if (in == nullptr) {
-    delete[] tempBuffers[0];
-    delete[] tempBuffers[1];
-  }
+XrunCounts AudioEngine::getXruns() const {
+  XrunCounts counts;
+  counts.inputUnderflow = xruns[0];
+  counts.inputOverflow = xruns[1];
+  counts.outputUnderflow = xruns[2];
+  counts.outputOverflow = xruns[3];
+  return counts;
+}
 
-  return paContinue;
+void AudioEngine::audioCallback(float **inputBuffer, float **outputBuffer,
+                                unsigned long framesPerBuffer,
+                                unsigned xrun) {
+  RealtimeGuard::AudioThread audioThread;
+  RealtimeGuard::ProcessorScope scope(processor);
+  LoadMeter::Scope timer(load, framesPerBuffer, config.sampleRate);
+  static thread_local bool named = false;
+  if (!named) {
+    Trace::nameThread("Audio");
+    named = true;
+  }
+  Trace::Span span("AudioEngine::audioCallback");
+  for (int i = 0; i < 4; ++i) {
+    if (xrun & (1u << i)) {
+      xruns[i].fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+  float *input[2];
+  float *output[2];
+  for (unsigned long offset = 0; offset < framesPerBuffer;
+       offset += MAX_FRAMES_PER_BUFFER) {
+    unsigned long n =
+        std::min(MAX_FRAMES_PER_BUFFER, framesPerBuffer - offset);
+    for (int channel = 0; channel < channels; ++channel) {
+      if (inputBuffer) {
+        input[channel] = inputBuffer[channel] + offset;
+      } else {
+        // Processors may have written over it last time
+        std::fill(silence[channel].begin(), silence[channel].begin() + n,
+                  0.0f);
+        input[channel] = silence[channel].data();
+      }
+      output[channel] = outputBuffer[channel] + offset;
+    }
+    Trace::Span processSpan("process", typeid(*processor));
+    if (config.blockSize) {
+      blocks.process(processor, input, output, n);
+    } else {
+      processor->process(input, output, n);
+    }
+    // The stream runs with clipping off, which integer devices would wrap
+    for (int channel = 0; channel < channels; ++channel) {
+      Kernels::clip(output[channel], output[channel], -1.0f, 1.0f, n);
+    }
+  }
 }
@@ -1,28 +1,61 @@
 #pragma once
 
 #include "../processors/Processor.hpp"
-#include <portaudio.h>
+#include "AudioBackend.hpp"
+#include "BlockAdapter.hpp"
+#include "BufferArena.hpp"
+#include "LoadMeter.hpp"
+#include <atomic>
 #include <vector>
 
 using std::vector;
 
+struct XrunCounts {
+  size_t inputUnderflow = 0;
+  size_t inputOverflow = 0;
+  size_t outputUnderflow = 0;
+  size_t outputOverflow = 0;
+};
+
 class AudioEngine {
-  PaStream *stream;
+  AudioBackend *backend;
   Processor *processor;
   int channels = 2;
-  int sampleRate = 44100;
-  float phase;
-  int inputChannelStart = 0;
-
-  static int audioCallback(const void *inputBuffer, void *outputBuffer,
-                           unsigned long framesPerBuffer,
-                           const PaStreamCallbackTimeInfo* timeInfo,
-                           PaStreamCallbackFlags flags, void *userData);
+  AudioConfig config;
+  bool running = false;
+  vector<float> silence[2]; // Input for devices without one
+  LoadMeter load;            // Whole callbacks against the buffer duration
+  BufferArena arena;         // Scratch for the processors it prepares
+  BlockAdapter blocks;       // Used when config.blockSize is set
+  std::atomic<size_t> xruns[4] = {}; // Indexed by the AudioXrun bit
 
 public:
+  static const unsigned long MIN_FRAMES_PER_BUFFER = 32;
+  static const unsigned long MAX_FRAMES_PER_BUFFER = 2048;
+
+  // Plays through the default PortAudio devices
   AudioEngine(Processor *proc, int inputChannelStart = 3);
+  // Takes ownership of the backend
+  AudioEngine(Processor *proc, AudioBackend *backend);
   ~AudioEngine();
   void start();
   void stop();
+  bool isRunning() const;
   Processor *getProcessor();
+  AudioBackend *getBackend();
+  vector<AudioDeviceInfo> listDevices();
+  static const vector<double> &getSupportedSampleRates();
+  // Throws on an unsupported rate, buffer or block size. A running engine
+  // is restarted with the new settings.
+  void setConfig(const AudioConfig &config);
+  const AudioConfig &getConfig() const;
+  unsigned long getBlockLatency() const; // In frames, added by re-blocking
+  // Both only read by one thread, the UI's
+  LoadMeter &getLoad();
+  XrunCounts getXruns() const; // Since the last start
+  // Called by the backend from its audio thread. A null input means the
+  // device has no input channels. Larger buffers than MAX_FRAMES_PER_BUFFER
+  // are processed in several calls. `xrun` holds AudioXrun bits.
+  void audioCallback(float **inputBuffer, float **outputBuffer,
+                     unsigned long framesPerBuffer, unsigned xrun = 0);
 };
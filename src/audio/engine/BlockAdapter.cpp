@@ -0,0 +1,56 @@
+#include "BlockAdapter.hpp"
+#include "Kernels.hpp"
+#include <algorithm>
+
+void BlockAdapter::prepare(size_t numChannels, size_t blockSize,
+                           size_t hostFrames) {
+  this->numChannels = numChannels;
+  this->blockSize = blockSize;
+  position = 0;
+  buffered = hostFrames % blockSize != 0;
+  input = BufferArena::current().allocate(numChannels, blockSize);
+  output = BufferArena::current().allocate(numChannels, blockSize);
+  inputs.assign(numChannels, nullptr);
+  outputs.assign(numChannels, nullptr);
+}
+
+void BlockAdapter::process(Processor *processor, float **inputBuffer,
+                           float **outputBuffer, size_t numSamples) {
+  if (!buffered.load(std::memory_order_relaxed)) {
+    if (numSamples % blockSize == 0) {
+      for (size_t offset = 0; offset < numSamples; offset += blockSize) {
+        for (size_t channel = 0; channel < numChannels; ++channel) {
+          inputs[channel] = inputBuffer[channel] + offset;
+          outputs[channel] = outputBuffer[channel] + offset;
+        }
+        processor->process(inputs.data(), outputs.data(), blockSize);
+      }
+      return;
+    }
+    // The output block is silent, so this buffer starts the delay cleanly
+    buffered.store(true, std::memory_order_relaxed);
+  }
+
+  for (size_t offset = 0; offset < numSamples;) {
+    size_t n = std::min(numSamples - offset, blockSize - position);
+    // Input first: the host buffers may be the same
+    for (size_t channel = 0; channel < numChannels; ++channel) {
+      Kernels::copy(input[channel] + position, inputBuffer[channel] + offset,
+                    n);
+      Kernels::copy(outputBuffer[channel] + offset, output[channel] + position,
+                    n);
+    }
+    position += n;
+    offset += n;
+    if (position == blockSize) {
+      processor->process(input.data(), output.data(), blockSize);
+      position = 0;
+    }
+  }
+}
+
+size_t BlockAdapter::getBlockSize() const { return blockSize; }
+
+size_t BlockAdapter::getLatency() const {
+  return buffered.load(std::memory_order_relaxed) ? blockSize : 0;
+}
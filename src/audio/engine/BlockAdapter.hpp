@@ -0,0 +1,33 @@
+#pragma once
+
+#include "../processors/Processor.hpp"
+#include "BufferArena.hpp"
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+using std::vector;
+
+// Feeds a processor fixed blocks of blockSize samples out of host buffers of
+// any size. When every host buffer is a whole number of blocks, they are cut
+// up in place with no added latency; otherwise samples go through a block of
+// input and a block of output, which delays them by exactly one block. A
+// host that once sends an odd-sized buffer keeps the delay from then on.
+class BlockAdapter {
+  size_t numChannels = 0;
+  size_t blockSize = 0;
+  size_t position = 0; // Samples filled in input, and played from output
+  std::atomic<bool> buffered{false};
+  BufferArena::Buffer input;
+  BufferArena::Buffer output;
+  vector<float *> inputs; // Channel pointers into the host buffers
+  vector<float *> outputs;
+
+public:
+  // Takes the blocks from the current arena
+  void prepare(size_t numChannels, size_t blockSize, size_t hostFrames);
+  void process(Processor *processor, float **inputBuffer,
+               float **outputBuffer, size_t numSamples);
+  size_t getBlockSize() const;
+  size_t getLatency() const; // In samples, may be read from any thread
+};
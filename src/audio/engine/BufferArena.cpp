@@ -0,0 +1,111 @@
+#include "BufferArena.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+thread_local BufferArena *active = nullptr;
+}
+
+void BufferArena::Pool::release(const Span &span) {
+  auto at = std::lower_bound(free.begin(), free.end(), span,
+                             [](const Span &a, const Span &b) {
+                               return a.chunk < b.chunk ||
+                                      (a.chunk == b.chunk &&
+                                       a.offset < b.offset);
+                             });
+  at = free.insert(at, span);
+  auto next = at + 1;
+  if (next != free.end() && next->chunk == at->chunk &&
+      at->offset + at->lines == next->offset) {
+    at->lines += next->lines;
+    free.erase(next);
+  }
+  if (at != free.begin()) {
+    auto previous = at - 1;
+    if (previous->chunk == at->chunk &&
+        previous->offset + previous->lines == at->offset) {
+      previous->lines += at->lines;
+      free.erase(at);
+    }
+  }
+}
+
+BufferArena::Buffer::Buffer(Buffer &&other) noexcept
+    : pool(std::move(other.pool)), span(other.span),
+      channels(std::move(other.channels)) {
+  other.span.lines = 0;
+}
+
+BufferArena::Buffer &BufferArena::Buffer::operator=(Buffer &&other) noexcept {
+  if (this != &other) {
+    if (pool && span.lines > 0) {
+      std::lock_guard<std::mutex> lock(pool->mutex);
+      pool->release(span);
+    }
+    pool = std::move(other.pool);
+    span = other.span;
+    channels = std::move(other.channels);
+    other.span.lines = 0;
+  }
+  return *this;
+}
+
+BufferArena::Buffer::~Buffer() {
+  if (pool && span.lines > 0) {
+    std::lock_guard<std::mutex> lock(pool->mutex);
+    pool->release(span);
+  }
+}
+
+BufferArena::Buffer BufferArena::allocate(size_t numChannels,
+                                          size_t numSamples) {
+  size_t stride = (numSamples + LINE_FLOATS - 1) / LINE_FLOATS;
+  size_t lines = std::max<size_t>(1, numChannels * stride);
+  Buffer buffer;
+  buffer.pool = pool;
+  Line *start;
+  {
+    std::lock_guard<std::mutex> lock(pool->mutex);
+    auto fit = std::find_if(pool->free.begin(), pool->free.end(),
+                            [lines](const Span &s) { return s.lines >= lines; });
+    if (fit == pool->free.end()) {
+      size_t size = std::max(CHUNK_LINES, lines);
+      pool->chunks.emplace_back(new Line[size]);
+      pool->chunkLines.push_back(size);
+      pool->release({pool->chunks.size() - 1, 0, size});
+      fit = pool->free.end() - 1;
+    }
+    buffer.span = {fit->chunk, fit->offset, lines};
+    fit->offset += lines;
+    fit->lines -= lines;
+    if (fit->lines == 0) {
+      pool->free.erase(fit);
+    }
+    start = pool->chunks[buffer.span.chunk].get() + buffer.span.offset;
+  }
+  memset(start, 0, lines * sizeof(Line));
+  for (size_t channel = 0; channel < numChannels; ++channel) {
+    buffer.channels.push_back(start[channel * stride].values);
+  }
+  return buffer;
+}
+
+size_t BufferArena::getCapacity() {
+  std::lock_guard<std::mutex> lock(pool->mutex);
+  size_t lines = 0;
+  for (const auto &size : pool->chunkLines) {
+    lines += size;
+  }
+  return lines;
+}
+
+BufferArena &BufferArena::current() {
+  static BufferArena shared;
+  return active ? *active : shared;
+}
+
+BufferArena::Use::Use(BufferArena &arena) : previous(active) {
+  active = &arena;
+}
+
+BufferArena::Use::~Use() { active = previous; }
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+using std::vector;
+
+// Scratch memory for processors, reserved in prepare. Buffers are carved out
+// of large chunks, every channel starting on a cache line, so that the
+// buffers of one engine sit together; a buffer's space goes back to the
+// arena when it is destroyed or replaced, for the next prepare to reuse.
+// Reserving takes a lock and may allocate: never on the audio thread.
+class BufferArena {
+public:
+  static const size_t LINE_FLOATS = 16; // 64 bytes
+
+private:
+  struct alignas(64) Line {
+    float values[LINE_FLOATS];
+  };
+  static const size_t CHUNK_LINES = 1 << 14; // 1 MiB
+
+  struct Span {
+    size_t chunk;
+    size_t offset; // In lines
+    size_t lines;
+  };
+  struct Pool {
+    std::mutex mutex;
+    vector<std::unique_ptr<Line[]>> chunks;
+    vector<size_t> chunkLines;
+    vector<Span> free; // Sorted, never adjacent
+    void release(const Span &span);
+  };
+  // Shared with the buffers, which may outlive the arena
+  std::shared_ptr<Pool> pool = std::make_shared<Pool>();
+
+public:
+  // Channels of zeros, as many samples each as asked for
+  class Buffer {
+    friend class BufferArena;
+    std::shared_ptr<Pool> pool;
+    Span span{0, 0, 0};
+    vector<float *> channels;
+
+  public:
+    Buffer() = default;
+    Buffer(Buffer &&other) noexcept;
+    Buffer &operator=(Buffer &&other) noexcept;
+    ~Buffer();
+    float **data() { return channels.data(); }
+    float *operator[](size_t channel) { return channels[channel]; }
+    size_t getNumChannels() const { return channels.size(); }
+  };
+
+  Buffer allocate(size_t numChannels, size_t numSamples);
+  // Lines held by the chunks, in use or not
+  size_t getCapacity();
+
+  // The arena that prepare calls on this thread should take from: the
+  // innermost Use, or one shared by everything outside an engine
+  static BufferArena &current();
+  class Use {
+    BufferArena *previous;
+
+  public:
+    Use(BufferArena &arena);
+    ~Use();
+  };
+};
@@ -0,0 +1,679 @@
+#include "Kernels.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define KERNELS_X86
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#define KERNELS_NEON
+#include <arm_neon.h>
+#endif
+
+namespace {
+
+struct Table {
+  const char *name;
+  void (*scale)(float *, const float *, float, size_t);
+  void (*scaleRamp)(float *, const float *, const float *, size_t);
+  void (*accumulate)(float *, const float *, float, size_t);
+  void (*mix)(float *, const float *, float, const float *, float, size_t);
+  void (*equalPowerMix)(float *, const float *, const float *, const float *,
+                        size_t);
+  void (*crossfade)(float *, const float *, const float *, size_t, size_t,
+                    size_t);
+  void (*clip)(float *, const float *, float, float, size_t);
+  void (*deinterleaveStereo)(float *, float *, const float *, size_t);
+};
+
+// The plain versions also finish what the vector ones leave over, so they
+// define the results: the others do the same operations in the same order
+
+void scaleScalar(float *out, const float *in, float gain, size_t n) {
+  for (size_t i = 0; i < n; ++i) {
+    out[i] = gain * in[i];
+  }
+}
+
+void scaleRampScalar(float *out, const float *in, const float *gains,
+                     size_t n) {
+  for (size_t i = 0; i < n; ++i) {
+    out[i] = gains[i] * in[i];
+  }
+}
+
+void accumulateScalar(float *out, const float *in, float gain, size_t n) {
+  for (size_t i = 0; i < n; ++i) {
+    out[i] += gain * in[i];
+  }
+}
+
+void mixScalar(float *out, const float *a, float gainA, const float *b,
+               float gainB, size_t n) {
+  for (size_t i = 0; i < n; ++i) {
+    out[i] = gainA * a[i] + gainB * b[i];
+  }
+}
+
+void equalPowerMixScalar(float *out, const float *a, const float *b,
+                         const float *mixes, size_t n) {
+  for (size_t i = 0; i < n; ++i) {
+    float m = mixes[i];
+    float oneminus = 1.0f - m;
+    float common = 1.0f / std::sqrt(m * m + oneminus * oneminus);
+    out[i] = common * (m * b[i] + oneminus * a[i]);
+  }
+}
+
+void crossfadeScalar(float *out, const float *from, const float *to,
+                     size_t position, size_t length, size_t n) {
+  for (size_t i = 0; i < n; ++i) {
+    float gain = std::min(1.0f, (float)(position + i) / (float)length);
+    out[i] = gain * to[i] + (1.0f - gain) * from[i];
+  }
+}
+
+void clipScalar(float *out, const float *in, float low, float high,
+                size_t n) {
+  for (size_t i = 0; i < n; ++i) {
+    out[i] = std::min(high, std::max(low, in[i]));
+  }
+}
+
+void deinterleaveStereoScalar(float *left, float *right, const float *in,
+                              size_t numFrames) {
+  for (size_t i = 0; i < numFrames; ++i) {
+    left[i] = in[2 * i];
+    right[i] = in[2 * i + 1];
+  }
+}
+
+const Table scalarTable = {"scalar",
+                           scaleScalar,
+                           scaleRampScalar,
+                           accumulateScalar,
+                           mixScalar,
+                           equalPowerMixScalar,
+                           crossfadeScalar,
+                           clipScalar,
+                           deinterleaveStereoScalar};
+
+#ifdef KERNELS_X86
+
+#define SSE __attribute__((target("sse2")))
+#define AVX2 __attribute__((target("avx2")))
+
+SSE void scaleSse(float *out, const float *in, float gain, size_t n) {
+  __m128 g = _mm_set1_ps(gain);
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    _mm_storeu_ps(out + i, _mm_mul_ps(g, _mm_loadu_ps(in + i)));
+  }
+  scaleScalar(out + i, in + i, gain, n - i);
+}
+
+SSE void scaleRampSse(float *out, const float *in, const float *gains,
+                      size_t n) {
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    _mm_storeu_ps(out + i,
+                  _mm_mul_ps(_mm_loadu_ps(gains + i), _mm_loadu_ps(in + i)));
+  }
+  scaleRampScalar(out + i, in + i, gains + i, n - i);
+}
+
+SSE void accumulateSse(float *out, const float *in, float gain, size_t n) {
+  __m128 g = _mm_set1_ps(gain);
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    __m128 sum =
+        _mm_add_ps(_mm_loadu_ps(out + i), _mm_mul_ps(g, _mm_loadu_ps(in + i)));
+    _mm_storeu_ps(out + i, sum);
+  }
+  accumulateScalar(out + i, in + i, gain, n - i);
+}
+
+SSE void mixSse(float *out, const float *a, float gainA, const float *b,
+                float gainB, size_t n) {
+  __m128 ga = _mm_set1_ps(gainA);
+  __m128 gb = _mm_set1_ps(gainB);
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    __m128 sum = _mm_add_ps(_mm_mul_ps(ga, _mm_loadu_ps(a + i)),
+                            _mm_mul_ps(gb, _mm_loadu_ps(b + i)));
+    _mm_storeu_ps(out + i, sum);
+  }
+  mixScalar(out + i, a + i, gainA, b + i, gainB, n - i);
+}
+
+SSE void equalPowerMixSse(float *out, const float *a, const float *b,
+                          const float *mixes, size_t n) {
+  __m128 one = _mm_set1_ps(1.0f);
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    __m128 m = _mm_loadu_ps(mixes + i);
+    __m128 oneminus = _mm_sub_ps(one, m);
+    __m128 common = _mm_div_ps(
+        one, _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(m, m),
+                                    _mm_mul_ps(oneminus, oneminus))));
+    __m128 sum = _mm_add_ps(_mm_mul_ps(m, _mm_loadu_ps(b + i)),
+                            _mm_mul_ps(oneminus, _mm_loadu_ps(a + i)));
+    _mm_storeu_ps(out + i, _mm_mul_ps(common, sum));
+  }
+  equalPowerMixScalar(out + i, a + i, b + i, mixes + i, n - i);
+}
+
+SSE void crossfadeSse(float *out, const float *from, const float *to,
+                      size_t position, size_t length, size_t n) {
+  __m128 one = _mm_set1_ps(1.0f);
+  __m128 lengths = _mm_set1_ps((float)length);
+  __m128 steps = _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f);
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    __m128 positions = _mm_add_ps(_mm_set1_ps((float)(position + i)), steps);
+    __m128 gain = _mm_min_ps(_mm_div_ps(positions, lengths), one);
+    __m128 sum = _mm_add_ps(
+        _mm_mul_ps(gain, _mm_loadu_ps(to + i)),
+        _mm_mul_ps(_mm_sub_ps(one, gain), _mm_loadu_ps(from + i)));
+    _mm_storeu_ps(out + i, sum);
+  }
+  crossfadeScalar(out + i, from + i, to + i, position + i, length, n - i);
+}
+
+SSE void clipSse(float *out, const float *in, float low, float high,
+                 size_t n) {
+  __m128 lows = _mm_set1_ps(low);
+  __m128 highs = _mm_set1_ps(high);
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    // Operands in the order that returns the bound for NaN, as std::max
+    // and std::min do
+    _mm_storeu_ps(out + i,
+                  _mm_min_ps(_mm_max_ps(_mm_loadu_ps(in + i), lows), highs));
+  }
+  clipScalar(out + i, in + i, low, high, n - i);
+}
+
+SSE void deinterleaveStereoSse(float *left, float *right, const float *in,
+                               size_t numFrames) {
+  size_t i = 0;
+  for (; i + 4 <= numFrames; i += 4) {
+    __m128 a = _mm_loadu_ps(in + 2 * i);
+    __m128 b = _mm_loadu_ps(in + 2 * i + 4);
+    _mm_storeu_ps(left + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+    _mm_storeu_ps(right + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+  }
+  deinterleaveStereoScalar(left + i, right + i, in + 2 * i, numFrames - i);
+}
+
+const Table sseTable = {"sse",
+                        scaleSse,
+                        scaleRampSse,
+                        accumulateSse,
+                        mixSse,
+                        equalPowerMixSse,
+                        crossfadeSse,
+                        clipSse,
+                        deinterleaveStereoSse};
+
+AVX2 void scaleAvx2(float *out, const float *in, float gain, size_t n) {
+  __m256 g = _mm256_set1_ps(gain);
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    _mm256_storeu_ps(out + i, _mm256_mul_ps(g, _mm256_loadu_ps(in + i)));
+  }
+  scaleScalar(out + i, in + i, gain, n - i);
+}
+
+AVX2 void scaleRampAvx2(float *out, const float *in, const float *gains,
+                        size_t n) {
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    _mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_loadu_ps(gains + i),
+                                            _mm256_loadu_ps(in + i)));
+  }
+  scaleRampScalar(out + i, in + i, gains + i, n - i);
+}
+
+AVX2 void accumulateAvx2(float *out, const float *in, float gain, size_t n) {
+  __m256 g = _mm256_set1_ps(gain);
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m256 sum = _mm256_add_ps(_mm256_loadu_ps(out + i),
+                               _mm256_mul_ps(g, _mm256_loadu_ps(in + i)));
+    _mm256_storeu_ps(out + i, sum);
+  }
+  accumulateScalar(out + i, in + i, gain, n - i);
+}
+
+AVX2 void mixAvx2(float *out, const float *a, float gainA, const float *b,
+                  float gainB, size_t n) {
+  __m256 ga = _mm256_set1_ps(gainA);
+  __m256 gb = _mm256_set1_ps(gainB);
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m256 sum = _mm256_add_ps(_mm256_mul_ps(ga, _mm256_loadu_ps(a + i)),
+                               _mm256_mul_ps(gb, _mm256_loadu_ps(b + i)));
+    _mm256_storeu_ps(out + i, sum);
+  }
+  mixScalar(out + i, a + i, gainA, b + i, gainB, n - i);
+}
+
+AVX2 void equalPowerMixAvx2(float *out, const float *a, const float *b,
+                            const float *mixes, size_t n) {
+  __m256 one = _mm256_set1_ps(1.0f);
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m256 m = _mm256_loadu_ps(mixes + i);
+    __m256 oneminus = _mm256_sub_ps(one, m);
+    __m256 common = _mm256_div_ps(
+        one, _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(m, m),
+                                          _mm256_mul_ps(oneminus, oneminus))));
+    __m256 sum = _mm256_add_ps(_mm256_mul_ps(m, _mm256_loadu_ps(b + i)),
+                               _mm256_mul_ps(oneminus, _mm256_loadu_ps(a + i)));
+    _mm256_storeu_ps(out + i, _mm256_mul_ps(common, sum));
+  }
+  equalPowerMixScalar(out + i, a + i, b + i, mixes + i, n - i);
+}
+
+AVX2 void crossfadeAvx2(float *out, const float *from, const float *to,
+                        size_t position, size_t length, size_t n) {
+  __m256 one = _mm256_set1_ps(1.0f);
+  __m256 lengths = _mm256_set1_ps((float)length);
+  __m256 steps = _mm256_set_ps(7.0f, 6.0f, 5.0f, 4.0f, 3.0f, 2.0f, 1.0f, 0.0f);
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m256 positions =
+        _mm256_add_ps(_mm256_set1_ps((float)(position + i)), steps);
+    __m256 gain = _mm256_min_ps(_mm256_div_ps(positions, lengths), one);
+    __m256 sum = _mm256_add_ps(
+        _mm256_mul_ps(gain, _mm256_loadu_ps(to + i)),
+        _mm256_mul_ps(_mm256_sub_ps(one, gain), _mm256_loadu_ps(from + i)));
+    _mm256_storeu_ps(out + i, sum);
+  }
+  crossfadeScalar(out + i, from + i, to + i, position + i, length, n - i);
+}
+
+AVX2 void clipAvx2(float *out, const float *in, float low, float high,
+                   size_t n) {
+  __m256 lows = _mm256_set1_ps(low);
+  __m256 highs = _mm256_set1_ps(high);
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m256 x = _mm256_max_ps(_mm256_loadu_ps(in + i), lows);
+    _mm256_storeu_ps(out + i, _mm256_min_ps(x, highs));
+  }
+  clipScalar(out + i, in + i, low, high, n - i);
+}
+
+AVX2 void deinterleaveStereoAvx2(float *left, float *right, const float *in,
+                                 size_t numFrames) {
+  size_t i = 0;
+  for (; i + 8 <= numFrames; i += 8) {
+    __m256 a = _mm256_loadu_ps(in + 2 * i);
+    __m256 b = _mm256_loadu_ps(in + 2 * i + 8);
+    // Shuffles stay within 128-bit halves: frames come out as 0 1 4 5 2 3
+    // 6 7 and the permute puts the pairs back in order
+    __m256 l = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+    __m256 r = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+    l = _mm256_castpd_ps(
+        _mm256_permute4x64_pd(_mm256_castps_pd(l), _MM_SHUFFLE(3, 1, 2, 0)));
+    r = _mm256_castpd_ps(
+        _mm256_permute4x64_pd(_mm256_castps_pd(r), _MM_SHUFFLE(3, 1, 2, 0)));
+    _mm256_storeu_ps(left + i, l);
+    _mm256_storeu_ps(right + i, r);
+  }
+  deinterleaveStereoScalar(left + i, right + i, in + 2 * i, numFrames - i);
+}
+
+const Table avx2Table = {"avx2",
+                         scaleAvx2,
+                         scaleRampAvx2,
+                         accumulateAvx2,
+                         mixAvx2,
+                         equalPowerMixAvx2,
+                         crossfadeAvx2,
+                         clipAvx2,
+                         deinterleaveStereoAvx2};
+
+#endif
+
+#ifdef KERNELS_NEON
+
+void scaleNeon(float *out, const float *in, float gain, size_t n) {
+  float32x4_t g = vdupq_n_f32(gain);
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    vst1q_f32(out + i, vmulq_f32(g, vld1q_f32(in + i)));
+  }
+  scaleScalar(out + i, in + i, gain, n - i);
+}
+
+void scaleRampNeon(float *out, const float *in, const float *gains,
+                   size_t n) {
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    vst1q_f32(out + i, vmulq_f32(vld1q_f32(gains + i), vld1q_f32(in + i)));
+  }
+  scaleRampScalar(out + i, in + i, gains + i, n - i);
+}
+
+// Separate multiplies and adds rather than vmla, which may fuse and round
+// differently from the plain version
+void accumulateNeon(float *out, const float *in, float gain, size_t n) {
+  float32x4_t g = vdupq_n_f32(gain);
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    vst1q_f32(out + i,
+              vaddq_f32(vld1q_f32(out + i), vmulq_f32(g, vld1q_f32(in + i))));
+  }
+  accumulateScalar(out + i, in + i, gain, n - i);
+}
+
+void mixNeon(float *out, const float *a, float gainA, const float *b,
+             float gainB, size_t n) {
+  float32x4_t ga = vdupq_n_f32(gainA);
+  float32x4_t gb = vdupq_n_f32(gainB);
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    vst1q_f32(out + i, vaddq_f32(vmulq_f32(ga, vld1q_f32(a + i)),
+                                 vmulq_f32(gb, vld1q_f32(b + i))));
+  }
+  mixScalar(out + i, a + i, gainA, b + i, gainB, n - i);
+}
+
+void clipNeon(float *out, const float *in, float low, float high, size_t n) {
+  float32x4_t lows = vdupq_n_f32(low);
+  float32x4_t highs = vdupq_n_f32(high);
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    // Selects rather than vmax and vmin, which return NaN for NaN
+    float32x4_t x = vld1q_f32(in + i);
+    x = vbslq_f32(vcltq_f32(lows, x), x, lows);
+    vst1q_f32(out + i, vbslq_f32(vcltq_f32(x, highs), x, highs));
+  }
+  clipScalar(out + i, in + i, low, high, n - i);
+}
+
+void deinterleaveStereoNeon(float *left, float *right, const float *in,
+                            size_t numFrames) {
+  size_t i = 0;
+  for (; i + 4 <= numFrames; i += 4) {
+    float32x4x2_t frames = vld2q_f32(in + 2 * i);
+    vst1q_f32(left + i, frames.val[0]);
+    vst1q_f32(right + i, frames.val[1]);
+  }
+  deinterleaveStereoScalar(left + i, right + i, in + 2 * i, numFrames - i);
+}
+
+#ifdef __aarch64__
+void equalPowerMixNeon(float *out, const float *a, const float *b,
+                       const float *mixes, size_t n) {
+  float32x4_t one = vdupq_n_f32(1.0f);
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    float32x4_t m = vld1q_f32(mixes + i);
+    float32x4_t oneminus = vsubq_f32(one, m);
+    float32x4_t common = vdivq_f32(
+        one, vsqrtq_f32(vaddq_f32(vmulq_f32(m, m),
+                                  vmulq_f32(oneminus, oneminus))));
+    float32x4_t sum = vaddq_f32(vmulq_f32(m, vld1q_f32(b + i)),
+                                vmulq_f32(oneminus, vld1q_f32(a + i)));
+    vst1q_f32(out + i, vmulq_f32(common, sum));
+  }
+  equalPowerMixScalar(out + i, a + i, b + i, mixes + i, n - i);
+}
+
+void crossfadeNeon(float *out, const float *from, const float *to,
+                   size_t position, size_t length, size_t n) {
+  float32x4_t one = vdupq_n_f32(1.0f);
+  float32x4_t lengths = vdupq_n_f32((float)length);
+  const float offsets[4] = {0.0f, 1.0f, 2.0f, 3.0f};
+  float32x4_t steps = vld1q_f32(offsets);
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    float32x4_t positions =
+        vaddq_f32(vdupq_n_f32((float)(position + i)), steps);
+    float32x4_t gain = vdivq_f32(positions, lengths);
+    gain = vbslq_f32(vcltq_f32(gain, one), gain, one);
+    float32x4_t sum =
+        vaddq_f32(vmulq_f32(gain, vld1q_f32(to + i)),
+                  vmulq_f32(vsubq_f32(one, gain), vld1q_f32(from + i)));
+    vst1q_f32(out + i, sum);
+  }
+  crossfadeScalar(out + i, from + i, to + i, position + i, length, n - i);
+}
+#else
+// 32-bit NEON has no exact division or square root
+#define equalPowerMixNeon equalPowerMixScalar
+#define crossfadeNeon crossfadeScalar
+#endif
+
+const Table neonTable = {"neon",
+                         scaleNeon,
+                         scaleRampNeon,
+                         accumulateNeon,
+                         mixNeon,
+                         equalPowerMixNeon,
+                         crossfadeNeon,
+                         clipNeon,
+                         deinterleaveStereoNeon};
+
+#endif
+
+Table select() {
+  const char *forced = getenv("LOGIISOUND_KERNELS");
+  bool any = !forced || !*forced;
+  auto allowed = [&](const char *name) {
+    return any || strcmp(forced, name) == 0;
+  };
+#ifdef KERNELS_X86
+  __builtin_cpu_init();
+  if (allowed("avx2") && __builtin_cpu_supports("avx2")) {
+    return avx2Table;
+  }
+  if (allowed("sse") && __builtin_cpu_supports("sse2")) {
+    return sseTable;
+  }
+#endif
+#ifdef KERNELS_NEON
+  if (allowed("neon")) {
+    return neonTable;
+  }
+#endif
+  return scalarTable;
+}
+
+const Table table = select();
+
+// Sets the CPU can run, besides the plain one
+std::vector<Table> vectorTables() {
+  std::vector<Table> tables;
+#ifdef KERNELS_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    tables.emplace_back(avx2Table);
+  }
+  if (__builtin_cpu_supports("sse2")) {
+    tables.emplace_back(sseTable);
+  }
+#endif
+#ifdef KERNELS_NEON
+  tables.emplace_back(neonTable);
+#endif
+  return tables;
+}
+
+// Inputs that are cheap to get wrong: signed zeros, denormals, values where
+// the clip bounds sit, and NaN, which only clip gets
+float testValue(size_t i, size_t salt, bool withNaN) {
+  const float specials[] = {0.0f,
+                            -0.0f,
+                            std::numeric_limits<float>::denorm_min(),
+                            -1.0f,
+                            1.0f,
+                            0.5f,
+                            -3.0e5f,
+                            std::numeric_limits<float>::quiet_NaN()};
+  size_t k = (i * 7 + salt * 3) % 11;
+  if (k < (withNaN ? 8u : 7u)) {
+    return specials[k];
+  }
+  return std::sin((float)(i * 13 + salt)) * 2.0f;
+}
+
+} // namespace
+
+void Kernels::copy(float *out, const float *in, size_t n) {
+  // libc's copy is already vectorized
+  if (out != in) {
+    memcpy(out, in, n * sizeof(float));
+  }
+}
+
+void Kernels::scale(float *out, const float *in, float gain, size_t n) {
+  table.scale(out, in, gain, n);
+}
+
+void Kernels::scaleRamp(float *out, const float *in, const float *gains,
+                        size_t n) {
+  table.scaleRamp(out, in, gains, n);
+}
+
+void Kernels::accumulate(float *out, const float *in, float gain, size_t n) {
+  table.accumulate(out, in, gain, n);
+}
+
+void Kernels::mix(float *out, const float *a, float gainA, const float *b,
+                  float gainB, size_t n) {
+  table.mix(out, a, gainA, b, gainB, n);
+}
+
+void Kernels::equalPowerMix(float *out, const float *a, const float *b,
+                            const float *mixes, size_t n) {
+  table.equalPowerMix(out, a, b, mixes, n);
+}
+
+void Kernels::crossfade(float *out, const float *from, const float *to,
+                        size_t position, size_t length, size_t n) {
+  table.crossfade(out, from, to, position, length, n);
+}
+
+void Kernels::clip(float *out, const float *in, float low, float high,
+                   size_t n) {
+  table.clip(out, in, low, high, n);
+}
+
+void Kernels::deinterleave(float **out, size_t offset, const float *in,
+                           size_t inChannels, size_t numChannels,
+                           size_t numFrames) {
+  if (inChannels == 2 && numChannels == 2) {
+    table.deinterleaveStereo(out[0] + offset, out[1] + offset, in, numFrames);
+    return;
+  }
+  if (inChannels == 1) {
+    for (size_t channel = 0; channel < numChannels; ++channel) {
+      copy(out[channel] + offset, in, numFrames);
+    }
+    return;
+  }
+  for (size_t channel = 0; channel < numChannels; ++channel) {
+    float *destination = out[channel] + offset;
+    size_t source = channel % inChannels;
+    for (size_t i = 0; i < numFrames; ++i) {
+      destination[i] = in[i * inChannels + source];
+    }
+  }
+}
+
+const char *Kernels::getName() { return table.name; }
+
+std::string Kernels::check() {
+  const size_t MAX_LENGTH = 37; // Past four AVX2 vectors, and one more
+  const size_t OFFSET = 1;      // Unaligned, as buffers may be
+  std::vector<float> a(2 * MAX_LENGTH + OFFSET), b(a.size()), c(a.size());
+  std::vector<float> mixes(a.size()), expected(a.size()), actual(a.size());
+  std::vector<float> expected2(a.size()), actual2(a.size()); // Right channel
+  std::string error;
+
+  for (const Table &t : vectorTables()) {
+    for (size_t n = 0; n <= MAX_LENGTH && error.empty(); ++n) {
+      for (size_t i = 0; i < a.size(); ++i) {
+        a[i] = testValue(i, n, false);
+        b[i] = testValue(i, n + 1, false);
+        c[i] = testValue(i, n + 2, true);
+        mixes[i] = std::fabs(std::sin((float)(i + n)));
+      }
+      const float *x = a.data() + OFFSET, *y = b.data() + OFFSET;
+      float *e = expected.data() + OFFSET, *r = actual.data() + OFFSET;
+      // Runs both versions on the same output contents and compares them
+      // bitwise, so that NaN and -0 count
+      auto compare = [&](const char *kernel, auto plain, auto vector) {
+        std::copy(b.begin(), b.end(), expected.begin());
+        std::copy(b.begin(), b.end(), actual.begin());
+        std::copy(b.begin(), b.end(), expected2.begin());
+        std::copy(b.begin(), b.end(), actual2.begin());
+        plain();
+        vector();
+        size_t bytes = expected.size() * sizeof(float);
+        if (error.empty() &&
+            (memcmp(expected.data(), actual.data(), bytes) != 0 ||
+             memcmp(expected2.data(), actual2.data(), bytes) != 0)) {
+          error = std::string(t.name) + " " + kernel +
+                  " differs from scalar with " + std::to_string(n) +
+                  " samples";
+        }
+      };
+      compare(
+          "scale", [&] { scaleScalar(e, x, 0.7f, n); },
+          [&] { t.scale(r, x, 0.7f, n); });
+      compare(
+          "scaleRamp", [&] { scaleRampScalar(e, x, mixes.data(), n); },
+          [&] { t.scaleRamp(r, x, mixes.data(), n); });
+      compare(
+          "accumulate", [&] { accumulateScalar(e, x, -1.3f, n); },
+          [&] { t.accumulate(r, x, -1.3f, n); });
+      compare(
+          "mix", [&] { mixScalar(e, x, 0.3f, y, -2.0f, n); },
+          [&] { t.mix(r, x, 0.3f, y, -2.0f, n); });
+      compare(
+          "equalPowerMix",
+          [&] { equalPowerMixScalar(e, x, y, mixes.data(), n); },
+          [&] { t.equalPowerMix(r, x, y, mixes.data(), n); });
+      for (size_t position : {(size_t)0, (size_t)5, (size_t)30}) {
+        compare(
+            "crossfade", [&] { crossfadeScalar(e, x, y, position, 32, n); },
+            [&] { t.crossfade(r, x, y, position, 32, n); });
+      }
+      const float *z = c.data() + OFFSET;
+      compare(
+          "clip", [&] { clipScalar(e, z, -0.0f, 0.5f, n); },
+          [&] { t.clip(r, z, -0.0f, 0.5f, n); });
+      compare(
+          "clip", [&] { clipScalar(e, z, -1.0f, 1.0f, n); },
+          [&] { t.clip(r, z, -1.0f, 1.0f, n); });
+      // In place, as processors call it
+      compare(
+          "clip in place",
+          [&] {
+            std::copy(c.begin(), c.end(), expected.begin());
+            clipScalar(e, e, -1.0f, 1.0f, n);
+          },
+          [&] {
+            std::copy(c.begin(), c.end(), actual.begin());
+            t.clip(r, r, -1.0f, 1.0f, n);
+          });
+      compare(
+          "deinterleaveStereo",
+          [&] {
+            deinterleaveStereoScalar(e, expected2.data(), a.data(), n);
+          },
+          [&] { t.deinterleaveStereo(r, actual2.data(), a.data(), n); });
+    }
+  }
+  return error;
+}
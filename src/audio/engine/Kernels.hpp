@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// Vector loops for the glue between processors: gains, mixes, copies. Each
+// has AVX2, SSE and NEON versions besides the plain one, and the best one
+// the CPU runs is picked at startup; LOGIISOUND_KERNELS=scalar, sse or avx2
+// forces a set. Every set gives the same results to the bit, none fusing a
+// multiply-add (Kernels.cpp is built with -ffp-contract=off). An output may
+// be the same buffer as an input, but not overlap it otherwise.
+class Kernels {
+public:
+  static void copy(float *out, const float *in, size_t n);
+  // out = gain * in
+  static void scale(float *out, const float *in, float gain, size_t n);
+  static void scaleRamp(float *out, const float *in, const float *gains,
+                        size_t n);
+  // out += gain * in
+  static void accumulate(float *out, const float *in, float gain, size_t n);
+  // out = gainA * a + gainB * b
+  static void mix(float *out, const float *a, float gainA, const float *b,
+                  float gainB, size_t n);
+  // Equal-power mix, b weighted by mixes[i] and a by 1 - mixes[i]
+  static void equalPowerMix(float *out, const float *a, const float *b,
+                            const float *mixes, size_t n);
+  // Linear fade from `from` to `to`, at (position + i) / length of the way
+  // for sample i and past the end after length
+  static void crossfade(float *out, const float *from, const float *to,
+                        size_t position, size_t length, size_t n);
+  static void clip(float *out, const float *in, float low, float high,
+                   size_t n);
+  // numFrames interleaved frames of inChannels into out[channel] + offset.
+  // Output channel c takes input channel c % inChannels, so mono goes to
+  // every channel and input channels past numChannels are dropped.
+  static void deinterleave(float **out, size_t offset, const float *in,
+                           size_t inChannels, size_t numChannels,
+                           size_t numFrames);
+  static const char *getName(); // The set in use
+  // Runs every set the CPU has against the plain one, over lengths that
+  // leave each vector loop a tail and inputs with NaN, signed zeros and
+  // denormals. Returns the first difference, empty when there is none.
+  static std::string check();
+};
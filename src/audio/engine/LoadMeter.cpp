@@ -0,0 +1,68 @@
+#include "LoadMeter.hpp"
+#include <algorithm>
+
+void LoadMeter::record(Clock::duration elapsed, size_t numSamples,
+                       float sampleRate) {
+  if (numSamples == 0 || sampleRate <= 0.0f) {
+    return;
+  }
+  double budget = numSamples / (double)sampleRate;
+  double percent =
+      100.0 * std::chrono::duration<double>(elapsed).count() / budget;
+  int bin = std::min((int)percent, NUM_BINS - 1);
+
+  // Single writer: plain loads and stores are enough for everything but max,
+  // which the reader clears
+  bins[bin].store(bins[bin].load(std::memory_order_relaxed) + 1,
+                  std::memory_order_relaxed);
+  sum.store(sum.load(std::memory_order_relaxed) + percent,
+            std::memory_order_relaxed);
+  double previous = max.load(std::memory_order_relaxed);
+  while (percent > previous &&
+         !max.compare_exchange_weak(previous, percent,
+                                    std::memory_order_relaxed)) {
+  }
+  calls.store(calls.load(std::memory_order_relaxed) + 1,
+              std::memory_order_release);
+}
+
+const LoadStats &LoadMeter::read(double interval) {
+  Clock::time_point now = Clock::now();
+  if (std::chrono::duration<double>(now - lastRefresh).count() < interval) {
+    return stats;
+  }
+  lastRefresh = now;
+
+  uint64_t total = calls.load(std::memory_order_acquire);
+  uint32_t window[NUM_BINS];
+  for (int i = 0; i < NUM_BINS; ++i) {
+    uint32_t count = bins[i].load(std::memory_order_relaxed);
+    window[i] = count - seenBins[i];
+    seenBins[i] = count;
+  }
+  double s = sum.load(std::memory_order_relaxed);
+
+  // The writer may have moved on while we copied, so the bins can hold a few
+  // more calls than `total`. That only nudges p99 for one window.
+  stats.calls = total - seenCalls;
+  stats.mean = stats.calls ? (s - seenSum) / stats.calls : 0.0;
+  stats.max = max.exchange(0.0, std::memory_order_relaxed);
+  stats.p99 = 0.0;
+  uint64_t binned = 0;
+  for (int i = 0; i < NUM_BINS; ++i) {
+    binned += window[i];
+  }
+  uint64_t target = binned - binned / 100;
+  uint64_t seen = 0;
+  for (int i = 0; i < NUM_BINS && binned > 0; ++i) {
+    seen += window[i];
+    if (seen >= target) {
+      // Upper edge of the bin, but never above the largest call measured
+      stats.p99 = std::min<double>(i + 1, std::max(stats.max, (double)i));
+      break;
+    }
+  }
+  seenCalls = total;
+  seenSum = s;
+  return stats;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+// Durations as a percentage of the time the processed samples last
+struct LoadStats {
+  size_t calls = 0;
+  double mean = 0.0;
+  double p99 = 0.0;
+  double max = 0.0;
+};
+
+// Histogram of process() durations. One thread records, typically the audio
+// thread, and one other thread reads; neither ever waits for the other.
+class LoadMeter {
+  static const int NUM_BINS = 201; // 1% wide, the last one holds overloads
+  std::atomic<uint32_t> bins[NUM_BINS] = {};
+  std::atomic<uint64_t> calls{0};
+  std::atomic<double> sum{0.0};
+  std::atomic<double> max{0.0};
+
+  // Reader side: what the histogram held at the last refresh
+  uint32_t seenBins[NUM_BINS] = {};
+  uint64_t seenCalls = 0;
+  double seenSum = 0.0;
+  std::chrono::steady_clock::time_point lastRefresh;
+  LoadStats stats;
+
+public:
+  using Clock = std::chrono::steady_clock;
+
+  void record(Clock::duration elapsed, size_t numSamples, float sampleRate);
+  // Statistics over the calls made between the two last refreshes. Calls
+  // made less than `interval` seconds after a refresh return the same
+  // statistics, so that a UI can poll every frame.
+  const LoadStats &read(double interval = 0.5);
+
+  // Times its own lifetime
+  class Scope {
+    LoadMeter &meter;
+    size_t numSamples;
+    float sampleRate;
+    Clock::time_point start;
+
+  public:
+    Scope(LoadMeter &meter, size_t numSamples, float sampleRate)
+        : meter(meter), numSamples(numSamples), sampleRate(sampleRate),
+          start(Clock::now()) {}
+    ~Scope() { meter.record(Clock::now() - start, numSamples, sampleRate); }
+  };
+};
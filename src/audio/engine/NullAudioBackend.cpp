@@ -0,0 +1,120 @@
+#include "NullAudioBackend.hpp"
+#include "AudioEngine.hpp"
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+
+NullAudioBackend::NullAudioBackend(NullPacing pacing) : pacing(pacing) {}
+
+NullAudioBackend::~NullAudioBackend() { stop(); }
+
+void NullAudioBackend::setInput(const vector<float> &samples, bool loop) {
+  input = samples;
+  this->loop = loop;
+}
+
+void NullAudioBackend::setRecordOutput(bool enabled) { record = enabled; }
+
+vector<AudioDeviceInfo> NullAudioBackend::listDevices() {
+  return {{0, "Null device", 2, 2, sampleRate}};
+}
+
+void NullAudioBackend::start(AudioEngine *engine, const AudioConfig &config) {
+  stop();
+  // Recorded frames are kept until the next start, so the stream must end
+  if (record && (loop || input.empty())) {
+    throw std::runtime_error(
+        "Recording the null device needs input that is not looped");
+  }
+  sampleRate = config.sampleRate;
+  framesProcessed = 0;
+  blocksProcessed = 0;
+  lateBlocks = 0;
+  recorded.clear();
+  if (record) {
+    recorded.reserve(input.size());
+  }
+  running = true;
+  thread = std::thread(&NullAudioBackend::run, this, engine,
+                       config.framesPerBuffer);
+}
+
+void NullAudioBackend::run(AudioEngine *engine,
+                           unsigned long framesPerBuffer) {
+  using Clock = std::chrono::steady_clock;
+  vector<float> inLeft(framesPerBuffer), inRight(framesPerBuffer);
+  vector<float> outLeft(framesPerBuffer), outRight(framesPerBuffer);
+  float *in[2] = {inLeft.data(), inRight.data()};
+  float *out[2] = {outLeft.data(), outRight.data()};
+  auto period = std::chrono::duration<double>(framesPerBuffer / sampleRate);
+  auto deadline = Clock::now();
+  size_t position = 0;
+  bool late = false;
+
+  while (running) {
+    size_t n = framesPerBuffer;
+    if (input.empty()) {
+      std::fill(inLeft.begin(), inLeft.end(), 0.0f);
+    } else {
+      if (position >= input.size()) {
+        if (!loop) {
+          break;
+        }
+        position = 0;
+      }
+      n = std::min<size_t>(framesPerBuffer, input.size() - position);
+      std::copy(input.begin() + position, input.begin() + position + n,
+                inLeft.begin());
+      position += n;
+    }
+    std::copy(inLeft.begin(), inLeft.begin() + n, inRight.begin());
+
+    // Reported with the next buffer, as PortAudio does
+    engine->audioCallback(in, out, n,
+                          late ? (unsigned)XRUN_OUTPUT_UNDERFLOW : 0u);
+    late = false;
+    if (record) {
+      recorded.insert(recorded.end(), outLeft.begin(), outLeft.begin() + n);
+    }
+    framesProcessed += n;
+    blocksProcessed++;
+
+    if (pacing == NullPacing::RealTime) {
+      deadline += std::chrono::duration_cast<Clock::duration>(period);
+      if (Clock::now() > deadline) {
+        // A sound card would have dropped this buffer and moved on
+        lateBlocks++;
+        late = true;
+        deadline = Clock::now();
+      } else {
+        std::this_thread::sleep_until(deadline);
+      }
+    }
+  }
+  running = false;
+}
+
+void NullAudioBackend::stop() {
+  running = false;
+  wait();
+}
+
+void NullAudioBackend::wait() {
+  if (thread.joinable()) {
+    thread.join();
+  }
+}
+
+bool NullAudioBackend::isRunning() const { return running; }
+
+const vector<float> &NullAudioBackend::getRecordedOutput() const {
+  return recorded;
+}
+
+double NullAudioBackend::getStreamTime() const {
+  return framesProcessed / sampleRate;
+}
+
+size_t NullAudioBackend::getBlocksProcessed() const { return blocksProcessed; }
+
+size_t NullAudioBackend::getLateBlocks() const { return lateBlocks; }
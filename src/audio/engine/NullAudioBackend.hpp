@@ -0,0 +1,57 @@
+#pragma once
+
+#include "AudioBackend.hpp"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using std::vector;
+
+enum class NullPacing {
+  RealTime,  // One buffer per buffer duration, like a sound card
+  Freewheel, // Next buffer as soon as the previous one is done
+};
+
+// Audio device without hardware: feeds a sample buffer (or silence) to the
+// engine from its own thread. Its clock counts frames, so stream time does
+// not depend on how fast the host runs.
+class NullAudioBackend : public AudioBackend {
+  NullPacing pacing;
+  vector<float> input;
+  bool loop = false;
+  bool record = false;
+  vector<float> recorded;
+
+  std::thread thread;
+  std::atomic<bool> running{false};
+  std::atomic<size_t> framesProcessed{0};
+  std::atomic<size_t> blocksProcessed{0};
+  std::atomic<size_t> lateBlocks{0};
+  double sampleRate = 44100.0;
+
+  void run(AudioEngine *engine, unsigned long framesPerBuffer);
+
+public:
+  NullAudioBackend(NullPacing pacing = NullPacing::RealTime);
+  ~NullAudioBackend();
+  // Mono samples sent to both input channels. Without input the device
+  // streams silence until stopped; otherwise it stops at the end of the
+  // samples unless loop is set.
+  void setInput(const vector<float> &samples, bool loop = false);
+  // Keeps the left output channel, read back with getRecordedOutput. Only
+  // with input that is not looped: start throws otherwise.
+  void setRecordOutput(bool enabled);
+  vector<AudioDeviceInfo> listDevices() override;
+  void start(AudioEngine *engine, const AudioConfig &config) override;
+  void stop() override;
+  // Blocks until the input has been played through
+  void wait();
+  bool isRunning() const;
+  // Only valid once wait() or stop() has returned: the device thread grows
+  // it while the stream runs
+  const vector<float> &getRecordedOutput() const;
+  double getStreamTime() const;
+  size_t getBlocksProcessed() const;
+  // Real-time pacing only: buffers whose callback ran past their deadline
+  size_t getLateBlocks() const;
+};
@@ -0,0 +1,80 @@
+#include "Parameter.hpp"
+#include <cmath>
+
+SmoothedParameter::SmoothedParameter(float value, Ramp ramp, float rampSeconds)
+    : target(value), ramp(ramp), rampSeconds(rampSeconds), current(value),
+      rampTarget(value) {}
+
+void SmoothedParameter::set(float value) {
+  target.store(value, std::memory_order_relaxed);
+}
+
+float SmoothedParameter::get() const {
+  return target.load(std::memory_order_relaxed);
+}
+
+void SmoothedParameter::prepare(float sampleRate, size_t maxBlockSize) {
+  rampLength = std::max<size_t>(1, std::lround(rampSeconds * sampleRate));
+  values = BufferArena::current().allocate(1, maxBlockSize);
+  current = rampTarget = get();
+  remaining = 0;
+  smoothing = false;
+}
+
+const float *SmoothedParameter::process(size_t numSamples) {
+  float *out = values[0];
+  float newTarget = target.load(std::memory_order_relaxed);
+  if (newTarget != rampTarget) {
+    rampTarget = newTarget;
+    remaining = rampLength;
+    exponential =
+        ramp == Ramp::Exponential && current > 0.0f && newTarget > 0.0f;
+    step = exponential ? std::pow(newTarget / current, 1.0f / remaining)
+                       : (newTarget - current) / remaining;
+  }
+
+  size_t n = std::min(numSamples, remaining);
+  smoothing = n > 0;
+  if (smoothing) {
+    // Plain loops over independent lanes, so that they vectorize
+    const float start = current;
+    if (exponential) {
+      const size_t LANES = 8;
+      float lane[LANES];
+      float factor = 1.0f;
+      for (size_t l = 0; l < LANES; ++l) {
+        factor *= step;
+        lane[l] = start * factor;
+      }
+      size_t i = 0;
+      for (; i + LANES <= n; i += LANES) {
+        for (size_t l = 0; l < LANES; ++l) {
+          out[i + l] = lane[l];
+          lane[l] *= factor;
+        }
+      }
+      for (size_t l = 0; i + l < n; ++l) {
+        out[i + l] = lane[l];
+      }
+    } else {
+      const float increment = step;
+      for (size_t i = 0; i < n; ++i) {
+        out[i] = start + increment * static_cast<float>(i + 1);
+      }
+    }
+    remaining -= n;
+    current = out[n - 1];
+  }
+  if (remaining == 0) {
+    // Lands exactly on the target, whatever the rounding on the way
+    current = rampTarget;
+    for (size_t i = n; i < numSamples; ++i) {
+      out[i] = rampTarget;
+    }
+  }
+  return out;
+}
+
+bool SmoothedParameter::isSmoothing() const { return smoothing; }
+
+float SmoothedParameter::getCurrent() const { return current; }
@@ -0,0 +1,110 @@
+#pragma once
+#include "BufferArena.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+enum class Ramp { Linear, Exponential };
+
+// A continuous processor setting, such as a gain or a frequency. Any thread
+// sets a target; the audio thread picks it up at the start of its next
+// buffer and glides to it over rampSeconds, with one value per sample.
+// Exponential ramps suit frequencies and the like, and fall back to linear
+// when either end isn't positive.
+class SmoothedParameter {
+  std::atomic<float> target;
+  Ramp ramp;
+  float rampSeconds;
+
+  // Audio side
+  float current;
+  float rampTarget;
+  float step = 0.0f; // Increment, or factor when exponential
+  bool exponential = false;
+  bool smoothing = false;
+  size_t remaining = 0;
+  size_t rampLength = 1;
+  BufferArena::Buffer values; // Sized in prepare
+
+public:
+  SmoothedParameter(float value, Ramp ramp = Ramp::Linear,
+                    float rampSeconds = 0.02f);
+  void set(float value);
+  float get() const; // Last target set
+  // Not while process runs. Jumps to the target.
+  void prepare(float sampleRate, size_t maxBlockSize);
+  // Audio thread, once per buffer: the value at each of the next numSamples
+  // samples
+  const float *process(size_t numSamples);
+  // Whether the last process call had a ramp, or a constant buffer
+  bool isSmoothing() const;
+  float getCurrent() const; // Value at the last sample processed
+};
+
+// A setting that jumps, such as a switch. Changes go through a lock-free
+// queue, each with the sample it applies at, so the audio thread can split
+// its buffer exactly there. One thread sets, the audio thread reads.
+template <typename T, size_t QUEUE_SIZE = 32> class SteppedParameter {
+  struct Event {
+    uint64_t time;
+    T value;
+  };
+  Event events[QUEUE_SIZE];
+  std::atomic<size_t> head{0};
+  std::atomic<size_t> tail{0};
+  std::atomic<uint64_t> position{0}; // Samples the audio thread went through
+  T latest;                          // Setter side
+  T value;                           // Audio side
+
+public:
+  SteppedParameter(T value) : latest(value), value(value) {}
+
+  // time is a sample position as given by getPosition; anything already
+  // past applies at the start of the next buffer. False when the queue is
+  // full, the change is then dropped.
+  bool set(T newValue, uint64_t time = 0) {
+    size_t h = head.load(std::memory_order_relaxed);
+    if (h - tail.load(std::memory_order_acquire) == QUEUE_SIZE) {
+      return false;
+    }
+    events[h % QUEUE_SIZE] = {time, newValue};
+    head.store(h + 1, std::memory_order_release);
+    latest = newValue;
+    return true;
+  }
+  T get() const { return latest; }
+  uint64_t getPosition() const {
+    return position.load(std::memory_order_relaxed);
+  }
+
+  // Audio thread. Applies the changes due now and returns how many of the
+  // next numSamples samples keep the current value; process those and call
+  // again for the rest.
+  size_t nextSegment(size_t numSamples) {
+    uint64_t now = position.load(std::memory_order_relaxed);
+    size_t t = tail.load(std::memory_order_relaxed);
+    size_t h = head.load(std::memory_order_acquire);
+    size_t length = numSamples;
+    for (; t < h; ++t) {
+      const Event &e = events[t % QUEUE_SIZE];
+      if (e.time > now) {
+        length = std::min<uint64_t>(numSamples, e.time - now);
+        break;
+      }
+      value = e.value;
+    }
+    tail.store(t, std::memory_order_release);
+    position.store(now + length, std::memory_order_relaxed);
+    return length;
+  }
+  // Audio thread, for users that only change at buffer boundaries: applies
+  // every change due within the next numSamples samples
+  T advance(size_t numSamples) {
+    for (size_t done = 0; done < numSamples;) {
+      done += nextSegment(numSamples - done);
+    }
+    return value;
+  }
+  T current() const { return value; }
+};
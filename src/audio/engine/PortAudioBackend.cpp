@@ -0,0 +1,202 @@
+#include "PortAudioBackend.hpp"
+#include "AudioEngine.hpp"
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+PortAudioBackend::PortAudioBackend(int inputChannelStart)
+    : stream(nullptr), inputChannelStart(inputChannelStart) {
+  PaError err = Pa_Initialize();
+  if (err != paNoError) {
+    throw std::runtime_error("Failed to initialize PortAudio");
+  }
+}
+
+PortAudioBackend::~PortAudioBackend() {
+  stop();
+  Pa_Terminate();
+}
+
+vector<AudioDeviceInfo> PortAudioBackend::listDevices() {
+  vector<AudioDeviceInfo> devices;
+  int count = Pa_GetDeviceCount();
+  for (int i = 0; i < count; ++i) {
+    const PaDeviceInfo *info = Pa_GetDeviceInfo(i);
+    if (info) {
+      devices.push_back({i, info->name, info->maxInputChannels,
+                         info->maxOutputChannels, info->defaultSampleRate});
+    }
+  }
+  return devices;
+}
+
+static PaDeviceIndex pickDevice(int requested, PaDeviceIndex fallback,
+                                const char *kind) {
+  if (requested < 0) {
+    if (fallback == paNoDevice) {
+      throw std::runtime_error(std::string("No default ") + kind +
+                               " device found");
+    }
+    return fallback;
+  }
+  if (requested >= Pa_GetDeviceCount()) {
+    throw std::runtime_error(std::string("No ") + kind + " device " +
+                             std::to_string(requested));
+  }
+  return requested;
+}
+
+void PortAudioBackend::start(AudioEngine *engine, const AudioConfig &config) {
+  if (this->stream) {
+    this->stop();
+  }
+  double sampleRate = config.sampleRate;
+  unsigned long framesPerBuffer = config.framesPerBuffer;
+
+  PaStreamParameters inputParameters;
+  inputParameters.device =
+      pickDevice(config.inputDevice, Pa_GetDefaultInputDevice(), "input");
+
+  // Set the correct input channels (2 channels starting at inputChannelStart)
+  inputParameters.channelCount = 2;
+  inputParameters.sampleFormat = paFloat32 | paNonInterleaved;
+
+  // Get device info to adjust parameters based on actual capabilities
+  const PaDeviceInfo *deviceInfo = Pa_GetDeviceInfo(inputParameters.device);
+  if (!deviceInfo) {
+    throw std::runtime_error("Failed to get device info");
+  }
+
+  // Check if the requested channels are available
+  if (inputChannelStart + 2 > deviceInfo->maxInputChannels) {
+    std::cerr << "Warning: Device only has " << deviceInfo->maxInputChannels
+              << " input channels, but channels " << inputChannelStart << "-"
+              << (inputChannelStart + 1) << " were requested." << std::endl;
+
+    // Fall back to default channels if requested ones are not available
+    inputChannelStart = 0;
+    std::cerr << "Falling back to channels 0-1" << std::endl;
+  }
+
+  std::cout << "Using input channels " << inputChannelStart << "-"
+            << (inputChannelStart + 1) << std::endl;
+
+  inputParameters.suggestedLatency =
+      config.lowLatency ? deviceInfo->defaultLowInputLatency
+                        : deviceInfo->defaultHighInputLatency;
+  inputParameters.hostApiSpecificStreamInfo = nullptr;
+
+  // Setup output parameters
+  PaStreamParameters outputParameters;
+  outputParameters.device =
+      pickDevice(config.outputDevice, Pa_GetDefaultOutputDevice(), "output");
+  outputParameters.channelCount = 2;
+  outputParameters.sampleFormat = paFloat32 | paNonInterleaved;
+
+  const PaDeviceInfo *outputInfo = Pa_GetDeviceInfo(outputParameters.device);
+  if (!outputInfo) {
+    throw std::runtime_error("Failed to get output device info");
+  }
+  outputParameters.suggestedLatency =
+      config.lowLatency ? outputInfo->defaultLowOutputLatency
+                        : outputInfo->defaultHighOutputLatency;
+
+  outputParameters.hostApiSpecificStreamInfo = nullptr;
+
+  std::cout << "Opening stream with input latency: "
+            << inputParameters.suggestedLatency
+            << "s, output latency: " << outputParameters.suggestedLatency
+            << "s, buffer size: " << framesPerBuffer << std::endl;
+
+  // Open stream with both input and output
+  PaError err =
+      Pa_OpenStream(&stream, &inputParameters, &outputParameters, sampleRate,
+                    framesPerBuffer, paClipOff, paCallback, engine);
+
+  if (err != paNoError && config.lowLatency) {
+    throw std::runtime_error("Failed to open low latency stream at " +
+                             std::to_string((int)sampleRate) + " Hz, " +
+                             std::to_string(framesPerBuffer) +
+                             " frames: " + Pa_GetErrorText(err));
+  }
+  if (err != paNoError) {
+    std::cerr << "Failed to open stream: " << Pa_GetErrorText(err) << std::endl;
+
+    // Fallback: try with even higher latency and larger buffer
+    inputParameters.suggestedLatency = 0.2;  // 200ms
+    outputParameters.suggestedLatency = 0.2; // 200ms
+    unsigned long fallbackFramesPerBuffer = 1024;
+
+    std::cout << "Trying fallback with higher latency (200ms) and larger "
+                 "buffer (1024)"
+              << std::endl;
+
+    err =
+        Pa_OpenStream(&stream, &inputParameters, &outputParameters, sampleRate,
+                      fallbackFramesPerBuffer, paClipOff, paCallback, engine);
+
+    if (err != paNoError) {
+      // Last resort: try output-only
+      std::cout << "Trying output-only stream as last resort" << std::endl;
+      err = Pa_OpenStream(&stream, nullptr, &outputParameters, sampleRate,
+                          fallbackFramesPerBuffer, paClipOff, paCallback,
+                          engine);
+
+      if (err != paNoError) {
+        throw std::runtime_error("Failed to open stream with PortAudio: " +
+                                 std::string(Pa_GetErrorText(err)));
+      }
+    }
+  }
+
+  err = Pa_StartStream(stream);
+  if (err != paNoError) {
+    std::cerr << "Failed to start stream: " << Pa_GetErrorText(err)
+              << std::endl;
+    Pa_CloseStream(stream);
+    throw std::runtime_error("Failed to start PortAudio stream: " +
+                             std::string(Pa_GetErrorText(err)));
+  }
+
+  const PaStreamInfo *streamInfo = Pa_GetStreamInfo(stream);
+  if (streamInfo) {
+    std::cout << "Stream successfully started with:"
+              << "\n  - Input latency: " << streamInfo->inputLatency << "s"
+              << "\n  - Output latency: " << streamInfo->outputLatency << "s"
+              << "\n  - Sample rate: " << streamInfo->sampleRate << "Hz"
+              << std::endl;
+  } else {
+    std::cout << "Stream started but couldn't get stream info" << std::endl;
+  }
+}
+
+void PortAudioBackend::stop() {
+  if (this->stream) {
+    Pa_StopStream(this->stream);
+    Pa_CloseStream(this->stream);
+    this->stream = nullptr;
+  }
+}
+
+int PortAudioBackend::paCallback(const void *inputBuffer, void *outputBuffer,
+                                 unsigned long framesPerBuffer,
+                                 const PaStreamCallbackTimeInfo *timeInfo,
+                                 PaStreamCallbackFlags flags, void *userData) {
+  AudioEngine *engine = static_cast<AudioEngine *>(userData);
+  unsigned xrun = 0;
+  if (flags & paInputUnderflow) {
+    xrun |= XRUN_INPUT_UNDERFLOW;
+  }
+  if (flags & paInputOverflow) {
+    xrun |= XRUN_INPUT_OVERFLOW;
+  }
+  if (flags & paOutputUnderflow) {
+    xrun |= XRUN_OUTPUT_UNDERFLOW;
+  }
+  if (flags & paOutputOverflow) {
+    xrun |= XRUN_OUTPUT_OVERFLOW;
+  }
+  engine->audioCallback((float **)inputBuffer, (float **)outputBuffer,
+                        framesPerBuffer, xrun);
+  return paContinue;
+}
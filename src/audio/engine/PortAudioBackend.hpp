@@ -0,0 +1,24 @@
+#pragma once
+
+#include "AudioBackend.hpp"
+#include <portaudio.h>
+#include <vector>
+
+using std::vector;
+
+class PortAudioBackend : public AudioBackend {
+  PaStream *stream;
+  int inputChannelStart = 0;
+
+  static int paCallback(const void *inputBuffer, void *outputBuffer,
+                        unsigned long framesPerBuffer,
+                        const PaStreamCallbackTimeInfo *timeInfo,
+                        PaStreamCallbackFlags flags, void *userData);
+
+public:
+  PortAudioBackend(int inputChannelStart = 3);
+  ~PortAudioBackend();
+  vector<AudioDeviceInfo> listDevices() override;
+  void start(AudioEngine *engine, const AudioConfig &config) override;
+  void stop() override;
+};
@@ -0,0 +1,149 @@
+#include "RealtimeGuard.hpp"
+
+#ifdef LOGIISOUND_RT_GUARD
+
+#include "../processors/Processor.hpp"
+#include <atomic>
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <iostream>
+#include <pthread.h>
+#include <typeinfo>
+
+namespace {
+
+enum Violation { Allocation, Deallocation, Lock, NUM_VIOLATIONS };
+const char *violationNames[] = {"heap allocation", "heap free", "mutex lock"};
+
+// One slot per (processor type, violation) pair, filled in without
+// allocating by the audio thread and the pool workers, concurrently
+struct Record {
+  std::atomic<const std::type_info *> type{nullptr};
+  std::atomic<int> kind{NUM_VIOLATIONS}; // Until the claiming thread sets it
+  std::atomic<size_t> count{0};
+};
+const int MAX_RECORDS = 64;
+Record records[MAX_RECORDS];
+std::atomic<size_t> dropped{0};
+
+thread_local bool onAudioThread = false;
+thread_local bool recording = false;
+thread_local const Processor *currentProcessor = nullptr;
+
+void record(Violation kind) {
+  if (!onAudioThread || recording) {
+    return;
+  }
+  recording = true;
+  const std::type_info *type =
+      currentProcessor ? &typeid(*currentProcessor) : &typeid(void);
+  bool found = false;
+  for (Record &r : records) {
+    const std::type_info *t = r.type.load();
+    if (t == nullptr && r.type.compare_exchange_strong(t, type)) {
+      // Only the thread that claimed the slot names its violation; the
+      // others see it unnamed for a moment and move on to the next slot
+      r.kind = kind;
+      t = type;
+    }
+    if (t == type && r.kind == kind) {
+      r.count++;
+      found = true;
+      break;
+    }
+  }
+  if (!found) {
+    dropped++;
+  }
+  recording = false;
+}
+
+} // namespace
+
+RealtimeGuard::AudioThread::AudioThread() : previous(onAudioThread) {
+  onAudioThread = true;
+}
+
+RealtimeGuard::AudioThread::~AudioThread() { onAudioThread = previous; }
+
+RealtimeGuard::ProcessorScope::ProcessorScope(const Processor *p)
+    : previous(currentProcessor) {
+  currentProcessor = p;
+}
+
+RealtimeGuard::ProcessorScope::~ProcessorScope() {
+  currentProcessor = previous;
+}
+
+size_t RealtimeGuard::report() {
+  size_t total = 0;
+  for (Record &r : records) {
+    size_t count = r.count.exchange(0);
+    const std::type_info *type = r.type.load();
+    if (count == 0 || type == nullptr) {
+      continue;
+    }
+    int status;
+    char *name = abi::__cxa_demangle(type->name(), nullptr, nullptr, &status);
+    std::cerr << "[RT]: " << count << " " << violationNames[r.kind]
+              << (count > 1 ? "s" : "") << " on the audio thread in "
+              << (status == 0 ? name : type->name()) << std::endl;
+    free(name);
+    total += count;
+  }
+  size_t lost = dropped.exchange(0);
+  if (lost > 0) {
+    std::cerr << "[RT]: " << lost << " more not attributed" << std::endl;
+  }
+  return total + lost;
+}
+
+#ifdef __GLIBC__
+// glibc lets the executable interpose the allocator; the real one stays
+// reachable under its __libc_ names.
+using LockFunction = int (*)(pthread_mutex_t *);
+// Resolved on first use rather than through a function-local static, whose
+// initialization guard may itself lock
+static std::atomic<LockFunction> nextLock{nullptr};
+
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *ptr, size_t size);
+void __libc_free(void *ptr);
+
+void *malloc(size_t size) noexcept {
+  record(Allocation);
+  return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size) noexcept {
+  record(Allocation);
+  return __libc_calloc(count, size);
+}
+
+void *realloc(void *ptr, size_t size) noexcept {
+  record(Allocation);
+  return __libc_realloc(ptr, size);
+}
+
+void free(void *ptr) noexcept {
+  if (ptr) {
+    record(Deallocation);
+  }
+  __libc_free(ptr);
+}
+
+int pthread_mutex_lock(pthread_mutex_t *mutex) noexcept {
+  LockFunction lock = nextLock.load();
+  if (!lock) {
+    lock = (LockFunction)dlsym(RTLD_NEXT, "pthread_mutex_lock");
+    nextLock = lock;
+  }
+  record(Lock);
+  return lock(mutex);
+}
+}
+#endif
+
+#endif
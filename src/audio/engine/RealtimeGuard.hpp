@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+
+class Processor;
+
+// Debug aid for the audio thread, enabled by LOGIISOUND_RT_GUARD. While a
+// thread holds an AudioThread, heap allocations, frees and mutex locks it
+// makes are recorded along with the processor that was running. Without the
+// flag every call here compiles to nothing.
+class RealtimeGuard {
+public:
+  class AudioThread {
+    bool previous;
+
+  public:
+    AudioThread();
+    ~AudioThread();
+  };
+
+  // Innermost processor running on the audio thread, for the report
+  class ProcessorScope {
+    const Processor *previous;
+
+  public:
+    ProcessorScope(const Processor *p);
+    ~ProcessorScope();
+  };
+
+  // Prints what was recorded since the last call to std::cerr and returns
+  // the number of violations. Not for the audio thread.
+  static size_t report();
+};
+
+#ifndef LOGIISOUND_RT_GUARD
+inline RealtimeGuard::AudioThread::AudioThread() : previous(false) {}
+inline RealtimeGuard::AudioThread::~AudioThread() {}
+inline RealtimeGuard::ProcessorScope::ProcessorScope(const Processor *)
+    : previous(nullptr) {}
+inline RealtimeGuard::ProcessorScope::~ProcessorScope() {}
+inline size_t RealtimeGuard::report() { return 0; }
+#endif
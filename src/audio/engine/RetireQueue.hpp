@@ -0,0 +1,47 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+// Objects the audio thread is done with, on their way to a thread that may
+// free them. Single producer (the audio thread, push) and single consumer
+// (the UI thread, collect); neither side locks or allocates.
+template <class T, size_t N> class RetireQueue {
+  T *items[N] = {};
+  std::atomic<size_t> head{0};
+  std::atomic<size_t> tail{0};
+
+public:
+  ~RetireQueue() { collect(); }
+
+  // Audio thread. Whether push has room for one more.
+  bool hasRoom() const {
+    return head.load(std::memory_order_relaxed) -
+               tail.load(std::memory_order_acquire) <
+           N;
+  }
+
+  // Audio thread. False when the queue is full and p stays with the caller.
+  bool push(T *p) {
+    if (!p) {
+      return true;
+    }
+    if (!hasRoom()) {
+      return false;
+    }
+    size_t h = head.load(std::memory_order_relaxed);
+    items[h % N] = p;
+    head.store(h + 1, std::memory_order_release);
+    return true;
+  }
+
+  // UI thread. Deletes everything pushed so far.
+  void collect() {
+    size_t t = tail.load(std::memory_order_relaxed);
+    size_t h = head.load(std::memory_order_acquire);
+    for (; t < h; ++t) {
+      delete items[t % N];
+    }
+    tail.store(t, std::memory_order_release);
+  }
+};
@@ -0,0 +1,205 @@
+#include "WorkerPool.hpp"
+#include "RealtimeGuard.hpp"
+#include "../../core/Trace.hpp"
+#include <chrono>
+#include <climits>
+#if defined(__unix__) || defined(__APPLE__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#include <immintrin.h>
+#endif
+
+namespace {
+uint64_t pack(uint64_t generation, uint64_t next, uint64_t count) {
+  return generation << 32 | next << 16 | count;
+}
+uint64_t nextOf(uint64_t state) { return state >> 16 & 0xffff; }
+uint64_t countOf(uint64_t state) { return state & 0xffff; }
+
+thread_local bool inJob = false;
+thread_local bool scheduleShared = false;
+
+// Lets the other hardware thread of the core run while this one spins
+void cpuRelax() {
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+  _mm_pause();
+#elif defined(__aarch64__) && defined(__GNUC__)
+  __asm__ __volatile__("yield");
+#endif
+}
+} // namespace
+
+WorkerPool &WorkerPool::instance() {
+  static WorkerPool pool;
+  return pool;
+}
+
+WorkerPool::~WorkerPool() { setThreads(0); }
+
+void WorkerPool::setThreads(size_t count) {
+  stopping = true;
+  unpark();
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  threads.clear();
+  stopping = false;
+  for (size_t i = 0; i < count; ++i) {
+    threads.emplace_back(&WorkerPool::work, this);
+  }
+}
+
+size_t WorkerPool::getThreads() const { return threads.size(); }
+
+bool WorkerPool::runClaimed() {
+  uint64_t s = state.load(std::memory_order_acquire);
+  while (nextOf(s) < countOf(s)) {
+    if (state.compare_exchange_weak(s, s + (1 << 16),
+                                    std::memory_order_acq_rel)) {
+      inJob = true;
+      job(context, nextOf(s));
+      inJob = false;
+      done.fetch_add(1, std::memory_order_release);
+      return true;
+    }
+  }
+  return false;
+}
+
+// Read once per calling thread: a worker below the audio thread holds it up
+// while it waits for the last job, and one above it preempts it
+void WorkerPool::shareSchedule() {
+#if defined(__unix__) || defined(__APPLE__)
+  int callerPolicy;
+  sched_param param{};
+  if (pthread_getschedparam(pthread_self(), &callerPolicy, &param) == 0) {
+    policy.store(callerPolicy, std::memory_order_relaxed);
+    priority.store(param.sched_priority, std::memory_order_relaxed);
+    scheduleVersion.fetch_add(1, std::memory_order_release);
+  }
+#endif
+  scheduleShared = true;
+}
+
+// Without the privilege, workers stay as they are
+void WorkerPool::followSchedule(unsigned &seenVersion) {
+  unsigned version = scheduleVersion.load(std::memory_order_acquire);
+  if (version == seenVersion) {
+    return;
+  }
+  seenVersion = version;
+#if defined(__unix__) || defined(__APPLE__)
+  sched_param param{};
+  param.sched_priority = priority.load(std::memory_order_relaxed);
+  pthread_setschedparam(pthread_self(), policy.load(std::memory_order_relaxed),
+                        &param);
+#endif
+}
+
+// Sleeps until unpark, unless it was called since `seen` was read
+void WorkerPool::park(uint32_t seen) {
+#ifdef __linux__
+  static_assert(sizeof(wakeups) == sizeof(uint32_t), "futex word");
+  syscall(SYS_futex, &wakeups, FUTEX_WAIT_PRIVATE, seen, nullptr, nullptr, 0);
+#else
+  std::unique_lock<std::mutex> lock(mutex);
+  wake.wait(lock, [&] {
+    return wakeups.load(std::memory_order_acquire) != seen;
+  });
+#endif
+}
+
+// A futex wake doesn't block, so run can call this from the audio thread
+void WorkerPool::unpark() {
+  wakeups.fetch_add(1, std::memory_order_release);
+#ifdef __linux__
+  syscall(SYS_futex, &wakeups, FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr,
+          0);
+#else
+  // Without the lock, the bump could fall between a worker's check and its
+  // wait
+  std::lock_guard<std::mutex> lock(mutex);
+  wake.notify_all();
+#endif
+}
+
+void WorkerPool::work() {
+  Trace::nameThread("Worker");
+  unsigned seenVersion = 0;
+  while (!stopping.load(std::memory_order_relaxed)) {
+    followSchedule(seenVersion);
+    auto spinStart = std::chrono::steady_clock::now();
+    bool worked = false;
+    for (int i = 0;; ++i) {
+      {
+        RealtimeGuard::AudioThread audioThread;
+        while (runClaimed()) {
+          worked = true;
+        }
+      }
+      if (worked || stopping.load(std::memory_order_relaxed)) {
+        break;
+      }
+      if (i % 64 == 63 && std::chrono::steady_clock::now() - spinStart >
+                              std::chrono::microseconds(SPIN_MICROSECONDS)) {
+        break;
+      }
+      cpuRelax();
+    }
+    if (worked) {
+      continue;
+    }
+    // Either run sees this worker parked and wakes it, or the check below
+    // sees its jobs
+    uint32_t seen = wakeups.load(std::memory_order_acquire);
+    parked.fetch_add(1, std::memory_order_seq_cst);
+    uint64_t s = state.load(std::memory_order_seq_cst);
+    if (!stopping.load(std::memory_order_seq_cst) && nextOf(s) >= countOf(s)) {
+      park(seen);
+    }
+    parked.fetch_sub(1, std::memory_order_relaxed);
+  }
+}
+
+void WorkerPool::run(size_t count, Job newJob, void *newContext) {
+  // Nested runs would overwrite the one in progress, and waiting for it
+  // from within one of its jobs could never end
+  if (!scheduleShared && !inJob) {
+    shareSchedule();
+  }
+  if (threads.empty() || count < 2 || count > MAX_JOBS || inJob ||
+      busy.exchange(true, std::memory_order_acquire)) {
+    for (size_t i = 0; i < count; ++i) {
+      newJob(newContext, i);
+    }
+    return;
+  }
+  job = newJob;
+  context = newContext;
+  done.store(0, std::memory_order_relaxed);
+  uint64_t generation = (state.load(std::memory_order_relaxed) >> 32) + 1;
+  state.store(pack(generation & 0xffffffff, 0, count),
+              std::memory_order_seq_cst);
+  if (parked.load(std::memory_order_seq_cst) > 0) {
+    unpark();
+  }
+  while (runClaimed()) {
+  }
+  // Only jobs that workers already hold are left. A worker still holding
+  // one after the pauses was likely preempted, maybe for this very thread.
+  for (int i = 0; done.load(std::memory_order_acquire) < count; ++i) {
+    if (i < WAIT_PAUSES) {
+      cpuRelax();
+    } else {
+      std::this_thread::yield();
+    }
+  }
+  busy.store(false, std::memory_order_release);
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using std::vector;
+
+// Threads that help the audio thread with independent work within a
+// callback, scheduled like the threads that call run. run never waits
+// for a worker to wake up: the calling thread claims jobs too, so a parked
+// or busy pool only costs parallelism. Workers spin for a while after their
+// last job, since the next one usually comes within the same callback, then
+// park.
+class WorkerPool {
+public:
+  typedef void (*Job)(void *context, size_t index);
+
+private:
+  static const int SPIN_MICROSECONDS = 100;
+  // Pauses run takes while workers finish their last jobs before it yields
+  static const int WAIT_PAUSES = 1024;
+  static const size_t MAX_JOBS = 0xffff;
+
+  // Generation, next index and job count packed together, so that a worker
+  // can't claim a job of a run that already finished
+  std::atomic<uint64_t> state{0};
+  std::atomic<size_t> done{0};
+  std::atomic<bool> busy{false}; // A run owns job, context and state
+  Job job = nullptr;
+  void *context = nullptr;
+
+  vector<std::thread> threads;
+  std::atomic<bool> stopping{false};
+  std::atomic<int> parked{0};
+  std::atomic<uint32_t> wakeups{0}; // Bumped to wake parked workers
+  // Scheduling policy and priority of the last thread new to run, which the
+  // workers take on when the version changes
+  std::atomic<int> policy{0};
+  std::atomic<int> priority{0};
+  std::atomic<unsigned> scheduleVersion{0};
+  // Parking without a futex
+  std::mutex mutex;
+  std::condition_variable wake;
+
+  WorkerPool() = default;
+  ~WorkerPool();
+  bool runClaimed(); // Runs one job if any is left
+  void shareSchedule();
+  void followSchedule(unsigned &seenVersion);
+  void park(uint32_t seen);
+  void unpark();
+  void work();
+
+public:
+  static WorkerPool &instance();
+  // Not while run is in progress
+  void setThreads(size_t count);
+  size_t getThreads() const;
+  // Calls job(context, i) for every i below count, across the pool and the
+  // calling thread, and returns once all are done. A call made from within
+  // a job, or while another thread's run is in progress, runs its jobs
+  // serially on the calling thread.
+  void run(size_t count, Job job, void *context);
+};
@@ -1,4 +1,8 @@
 #include "AddProcessor.hpp"
+#include "../engine/Kernels.hpp"
+#include "../engine/WorkerPool.hpp"
+#include <algorithm>
+#include <chrono>
 #include <cmath>
 #include <cstdlib>
 #include <imgui.h>
@@ -11,10 +15,6 @@ AddProcessor::AddProcessor(Processor *a, Processor *b) : Processor() {
 AddProcessor::~AddProcessor() {
   delete a;
   delete b;
-  for (size_t channel = 0; channel < numChannels; ++channel) {
-    free(buffer[channel]);
-  }
-  free(buffer);
 }
 
 void AddProcessor::render() {
@@ -28,37 +28,78 @@ void AddProcessor::render() {
   ImGui::Text("Add Processor");
   ImGui::BeginTable("addtable", 2, ImGuiTableFlags_BordersV);
   ImGui::TableNextColumn();
+  a->renderLoad();
   a->render();
   ImGui::TableNextColumn();
+  b->renderLoad();
   b->render();
   ImGui::EndTable();
   ImGui::Separator();
   ImGui::Text("Mix");
   ImGui::SameLine();
-  ImGui::SliderFloat("##addprocslider", &this->mix, 0.0f, 1.0f, "%.2f");
+  float mixValue = mix.get();
+  if (ImGui::SliderFloat("##addprocslider", &mixValue, 0.0f, 1.0f, "%.2f")) {
+    mix.set(mixValue);
+  }
   ImGui::EndChild();
 }
 
+void AddProcessor::prepare(float sampleRate, size_t numChannels,
+                           size_t maxBlockSize) {
+  Processor::prepare(sampleRate, numChannels, maxBlockSize);
+  buffer = BufferArena::current().allocate(numChannels, maxBlockSize);
+  mix.prepare(sampleRate, maxBlockSize);
+  a->prepare(sampleRate, numChannels, maxBlockSize);
+  b->prepare(sampleRate, numChannels, maxBlockSize);
+  cheaperSeconds = 0.0;
+  WorkerPool::instance();
+}
+
+void AddProcessor::setParallelMinSeconds(double seconds) {
+  parallelMinSeconds = seconds;
+}
+
+void AddProcessor::runBranch(void *add, size_t index) {
+  auto *self = static_cast<AddProcessor *>(add);
+  Processor *p = index == 0 ? self->a : self->b;
+  float **buffers = self->branchBuffers[index];
+  LoadMeter::Clock::time_point start = LoadMeter::Clock::now();
+  runChild(p, buffers, buffers, self->branchSamples);
+  self->branchSeconds[index] =
+      std::chrono::duration<double>(LoadMeter::Clock::now() - start).count();
+}
+
 void AddProcessor::process(float **inputBuffer, float **outputBuffer,
                            size_t numSamples) {
-  if (this->buffer == nullptr) {
-    this->buffer = (float **)malloc(numChannels * sizeof(float *));
-    for (size_t channel = 0; channel < numChannels; channel++) {
-      this->buffer[channel] = (float *)malloc(numSamples * sizeof(float));
-      memcpy(this->buffer[channel], inputBuffer[channel], numSamples);
-      memcpy(outputBuffer[channel], inputBuffer[channel], numSamples);
-    }
+  // Both branches get the input, b through its own buffer
+  for (size_t channel = 0; channel < numChannels; channel++) {
+    Kernels::copy(buffer[channel], inputBuffer[channel], numSamples);
+    Kernels::copy(outputBuffer[channel], inputBuffer[channel], numSamples);
+  }
+  const float *mixes = mix.process(numSamples);
+  branchBuffers[0] = outputBuffer;
+  branchBuffers[1] = buffer.data();
+  branchSamples = numSamples;
+  if (cheaperSeconds >= parallelMinSeconds) {
+    // One branch stays on this thread, the other goes to a worker if one is
+    // awake
+    WorkerPool::instance().run(2, &AddProcessor::runBranch, this);
+  } else {
+    runBranch(this, 0);
+    runBranch(this, 1);
   }
-  float oneminus = 1.0 - this->mix;
-  float common = 1.0 / sqrtf(this->mix * this->mix + oneminus * oneminus);
-  this->a->process(outputBuffer, outputBuffer, numSamples);
-  this->b->process(buffer, buffer, numSamples);
+  cheaperSeconds = 0.9 * cheaperSeconds +
+                   0.1 * std::min(branchSeconds[0], branchSeconds[1]);
+  float m = mix.getCurrent();
+  float oneminus = 1.0 - m;
+  float common = 1.0 / sqrtf(m * m + oneminus * oneminus);
   for (size_t channel = 0; channel < numChannels; channel++) {
-    for (size_t sample = 0; sample < numSamples; sample++) {
-      float valueA = outputBuffer[channel][sample];
-      float valueB = buffer[channel][sample];
-      outputBuffer[channel][sample] =
-          common * (mix * valueB + oneminus * valueA);
+    if (mix.isSmoothing()) {
+      Kernels::equalPowerMix(outputBuffer[channel], outputBuffer[channel],
+                             buffer[channel], mixes, numSamples);
+    } else {
+      Kernels::mix(outputBuffer[channel], outputBuffer[channel],
+                   common * oneminus, buffer[channel], common * m, numSamples);
     }
   }
 }
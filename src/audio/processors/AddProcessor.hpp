@@ -1,11 +1,28 @@
 #pragma once
 #include "Processor.hpp"
+#include "../engine/BufferArena.hpp"
+#include "../engine/Parameter.hpp"
+#include <vector>
 
+using std::vector;
+
+// Runs a and b side by side on the same input and mixes their outputs. The
+// branches go to the worker pool together, unless the cheaper one takes so
+// little time that handing it over would cost more than it saves.
 class AddProcessor : public Processor {
+  static constexpr double PARALLEL_MIN_SECONDS = 50e-6;
+
   Processor *a;
   Processor *b;
-  float **buffer = nullptr;
-  float mix = 0.5f;
+  BufferArena::Buffer buffer; // Input of b, sized in prepare
+  SmoothedParameter mix{0.5f};
+  float **branchBuffers[2];
+  size_t branchSamples = 0;
+  double branchSeconds[2] = {};
+  double cheaperSeconds = 0.0; // Smoothed over calls
+  double parallelMinSeconds = PARALLEL_MIN_SECONDS;
+
+  static void runBranch(void *add, size_t index);
 
 public:
   AddProcessor(Processor *a, Processor *b);
@@ -13,4 +30,9 @@ public:
   void render() override;
   void process(float **inputBuffer, float **outputBuffer,
                size_t numSamples) override;
+  void prepare(float sampleRate, size_t numChannels,
+               size_t maxBlockSize) override;
+  // How long the cheaper branch must take before the branches run in
+  // parallel: 0 for always, infinity for never
+  void setParallelMinSeconds(double seconds);
 };
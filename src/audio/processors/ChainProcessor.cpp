@@ -1,5 +1,6 @@
 #include "ChainProcessor.hpp"
 #include "Processor.hpp"
+#include "../engine/Kernels.hpp"
 #include <imgui.h>
 
 void ChainProcessor::render() {
@@ -10,6 +11,7 @@ void ChainProcessor::render() {
     } else {
       first = false;
     }
+    p->renderLoad();
     p->render();
   }
 }
@@ -17,12 +19,11 @@ void ChainProcessor::render() {
 void ChainProcessor::process(float **inputBuffer, float **outputBuffer,
                              size_t numSamples) {
 
-  if (inputBuffer != outputBuffer) {
-    memcpy(outputBuffer[0], inputBuffer[0], sizeof(float) * numSamples);
-    memcpy(outputBuffer[1], inputBuffer[1], sizeof(float) * numSamples);
+  for (size_t channel = 0; channel < numChannels; ++channel) {
+    Kernels::copy(outputBuffer[channel], inputBuffer[channel], numSamples);
   }
   for (Processor *p : this->processors) {
-    p->process(outputBuffer, outputBuffer, numSamples);
+    runChild(p, outputBuffer, outputBuffer, numSamples);
   }
 }
 
@@ -32,7 +33,16 @@ ChainProcessor::~ChainProcessor() {
   }
 }
 
+void ChainProcessor::prepare(float sampleRate, size_t numChannels,
+                             size_t maxBlockSize) {
+  Processor::prepare(sampleRate, numChannels, maxBlockSize);
+  for (Processor *p : this->processors) {
+    p->prepare(sampleRate, numChannels, maxBlockSize);
+  }
+}
+
 void ChainProcessor::addProcessor(Processor *p) {
+  p->prepare(sampleRate, numChannels, maxBlockSize);
   this->processors.emplace_back(p);
 }
 
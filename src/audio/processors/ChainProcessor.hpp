@@ -13,6 +13,8 @@ public:
   void render() override;
   void process(float **inputBuffer, float **outputBuffer,
                size_t numSamples) override;
+  void prepare(float sampleRate, size_t numChannels,
+               size_t maxBlockSize) override;
   void addProcessor(Processor *p);
   void clear();
 };
@@ -1,23 +1,100 @@
 #include "CircuitProcessor.hpp"
+#include <cfloat>
 #include <imgui.h>
 
-CircuitProcessor::CircuitProcessor(Circuit *c) : Processor(), circuit(c) {}
+CircuitProcessor::CircuitProcessor(Circuit *c)
+    : Processor(), circuit(c), time(0.0) {}
 
 CircuitProcessor::~CircuitProcessor() { delete circuit; }
 
 void CircuitProcessor::render() {
-  // TODO
   ImGui::Text("Circuit Processor");
+  const SolverSnapshot &stats = circuit->getStats().read(0.5);
+  if (stats.samples == 0) {
+    return;
+  }
+  // Samples by Newton iterations, from one iteration up
+  float histogram[SolverSnapshot::NUM_BINS - 1];
+  for (int i = 1; i < SolverSnapshot::NUM_BINS; ++i) {
+    histogram[i - 1] = stats.iterations[i];
+  }
+  ImGui::PushID(ImGuiHash);
+  ImGui::PlotHistogram("##iterations", histogram, SolverSnapshot::NUM_BINS - 1,
+                       0, "Newton iterations", 0.0f, FLT_MAX, ImVec2(0, 50));
+  ImGui::PopID();
+  ImGui::Text("%.2f iterations/sample, %llu not converged, residual %.1e",
+              stats.meanIterations(), (unsigned long long)stats.nonConverged,
+              stats.maxResidual);
+  ImGui::Text("%.1f factorizations/buffer (max %llu), worst sample %.1f us",
+              stats.buffers ? (double)stats.factorizations / stats.buffers
+                            : 0.0,
+              (unsigned long long)stats.maxFactorizationsPerBuffer,
+              stats.worstSampleNs / 1000.0);
+  if (stats.degradedBuffers) {
+    ImGui::Text("%llu buffers degraded to meet the deadline, %llu samples",
+                (unsigned long long)stats.degradedBuffers,
+                (unsigned long long)stats.degradedSamples);
+  }
+
+  ImGui::PushID(ImGuiHash + 1);
+  if (ImGui::Checkbox("Hardware counters", &countersOn)) {
+    circuit->setPerfCounters(countersOn);
+  }
+  ImGui::PopID();
+  PerfCounters *counters = circuit->getPerfCounters();
+  if (!countersOn || !counters) {
+    return;
+  }
+  std::string error = counters->getError();
+  if (!error.empty()) {
+    ImGui::TextDisabled("perf_event_open failed: %s", error.c_str());
+    return;
+  }
+  for (int p = 0; p < NUM_PERF_PHASES; ++p) {
+    PerfCounts c = counters->read((PerfPhase)p);
+    if (c.calls == 0 || c.cycles == 0) {
+      continue;
+    }
+    ImGui::Text("%-12s %.2f IPC, %.0f cycles, %.2f cache and %.2f branch "
+                "misses per call",
+                PerfCounters::phaseName((PerfPhase)p),
+                (double)c.instructions / c.cycles, (double)c.cycles / c.calls,
+                (double)c.cacheMisses / c.calls,
+                (double)c.branchMisses / c.calls);
+  }
+}
+
+void CircuitProcessor::prepare(float sampleRate, size_t numChannels,
+                               size_t maxBlockSize) {
+  Processor::prepare(sampleRate, numChannels, maxBlockSize);
+  circuit->prepare();
 }
 
 void CircuitProcessor::process(float **inputBuffer, float **outputBuffer,
                                size_t numSamples) {
-
+  circuit->setDeadline(budget.load(std::memory_order_relaxed) * numSamples /
+                       sampleRate);
   circuit->solveTransient(time, 1.0 / sampleRate, numSamples, inputNode,
                           outputNode, outputNode, inputBuffer, outputBuffer);
   time += (double)numSamples / sampleRate;
 }
 
+Circuit *CircuitProcessor::getCircuit() { return circuit; }
+
+void CircuitProcessor::setCircuit(Circuit *c) { circuit = c; }
+
+int CircuitProcessor::getInput() const { return inputNode; }
+
+int CircuitProcessor::getOutput() const { return outputNode; }
+
+void CircuitProcessor::setBudget(float fraction) {
+  budget.store(fraction, std::memory_order_relaxed);
+}
+
+float CircuitProcessor::getBudget() const {
+  return budget.load(std::memory_order_relaxed);
+}
+
 void CircuitProcessor::setInput(int node){
   inputNode = node;
 }
@@ -25,3 +102,14 @@ void CircuitProcessor::setInput(int node){
 void CircuitProcessor::setOutput(int node) {
   outputNode = node;
 }
+
+void CircuitProcessor::addParameter(int componentId, const std::string &name,
+                                    CircuitParameter *parameter) {
+  parameters[{componentId, name}] = parameter;
+}
+
+CircuitParameter *CircuitProcessor::getParameter(int componentId,
+                                                 const std::string &name) {
+  auto it = parameters.find({componentId, name});
+  return it == parameters.end() ? nullptr : it->second;
+}
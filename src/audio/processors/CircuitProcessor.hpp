@@ -2,22 +2,42 @@
 
 #include "../../circuits/Circuit.hpp"
 #include "Processor.hpp"
+#include <atomic>
+#include <map>
+#include <string>
+#include <utility>
 
 class CircuitProcessor : public Processor {
   Circuit *circuit;
   double time;
   int outputNode;
   int inputNode;
+  bool countersOn = false;
+  std::atomic<float> budget{0.0f};
+  // By editor component id and JSON key
+  std::map<std::pair<int, std::string>, CircuitParameter *> parameters;
 
 public:
   CircuitProcessor(Circuit *c);
   ~CircuitProcessor();
   void render() override;
+  void prepare(float sampleRate, size_t numChannels,
+               size_t maxBlockSize) override;
   void process(float **inputBuffer, float **outputBuffer,
                size_t numSamples) override;
   Circuit *getCircuit();
   void setCircuit(Circuit *c);
   void setInput(int node);
   void setOutput(int node);
-
+  int getInput() const;
+  int getOutput() const;
+  // Share of each buffer's duration the circuit may take before it trades
+  // accuracy for time, see Circuit::setDeadline. 0, the default, for none:
+  // offline renders must not depend on how fast they run.
+  void setBudget(float fraction);
+  float getBudget() const;
+  void addParameter(int componentId, const std::string &name,
+                    CircuitParameter *parameter);
+  // nullptr if the circuit has no such live parameter
+  CircuitParameter *getParameter(int componentId, const std::string &name);
 };
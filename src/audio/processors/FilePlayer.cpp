@@ -1,5 +1,8 @@
 #include "FilePlayer.hpp"
 #include "Processor.hpp"
+#include "../engine/Kernels.hpp"
+#include <algorithm>
+#include <cstring>
 #include <filesystem>
 #include <imgui.h>
 #include <iostream>
@@ -8,7 +11,14 @@
 
 FilePlayer::FilePlayer() : Processor() {}
 
+FilePlayer::~FilePlayer() {
+  retired.collect();
+  delete pending.load();
+  delete active;
+}
+
 void FilePlayer::render() {
+  retired.collect();
   ImGui::Text("File Player");
   ImGui::PushID(ImGuiHash);
   if (ImGui::Button("Browse##")) {
@@ -16,7 +26,10 @@ void FilePlayer::render() {
   }
   ImGui::PopID();
   ImGui::PushID(ImGuiHash + 1);
-  ImGui::Checkbox("Loop##", &this->loop);
+  bool looping = loop.get();
+  if (ImGui::Checkbox("Loop##", &looping)) {
+    loop.set(looping);
+  }
   ImGui::PopID();
   ImGui::PushID(ImGuiHash + 2);
   string name = "";
@@ -29,6 +42,8 @@ void FilePlayer::render() {
   ImGui::PopID();
 }
 
+// UI thread. The audio thread keeps playing the previous clip until it
+// picks the new one up.
 bool FilePlayer::loadAudioFile(const string &filePath) {
   SNDFILE *file;
   SF_INFO sfinfo;
@@ -41,20 +56,61 @@ bool FilePlayer::loadAudioFile(const string &filePath) {
   std::cout << "Loaded file sample rate: " << sfinfo.samplerate << " Hz"
             << std::endl;
 
-  if (sfinfo.samplerate != 44100) {
-    std::cerr << "Sample rate mismatch" << std::endl;
-    sf_close(file);
-    return false;
-  }
-
-  audioData.resize(sfinfo.frames * sfinfo.channels);
-  sf_read_float(file, &audioData[0], audioData.size());
+  fileData.resize(sfinfo.frames * sfinfo.channels);
+  sf_read_float(file, &fileData[0], fileData.size());
   sf_close(file);
+  fileSampleRate = sfinfo.samplerate;
+  fileChannels = sfinfo.channels;
   path = filePath;
-  playhead = 0;
+  publish(resample());
   return true;
 }
 
+void FilePlayer::publish(Clip *clip) {
+  // The audio thread takes pending with an exchange too, so whatever we get
+  // back here was never seen by it
+  delete pending.exchange(clip, std::memory_order_acq_rel);
+}
+
+void FilePlayer::prepare(float sampleRate, size_t numChannels,
+                         size_t maxBlockSize) {
+  Processor::prepare(sampleRate, numChannels, maxBlockSize);
+  // The audio thread isn't running, so the clip can be replaced in place
+  delete pending.exchange(nullptr);
+  delete active;
+  active = resample();
+  playhead = 0;
+}
+
+// Linear interpolation to the rate the engine runs at. Null without a file.
+FilePlayer::Clip *FilePlayer::resample() const {
+  if (fileData.empty()) {
+    return nullptr;
+  }
+  Clip *clip = new Clip();
+  clip->channels = fileChannels;
+  if (fileSampleRate == (int)sampleRate) {
+    clip->samples = fileData;
+    return clip;
+  }
+  size_t inFrames = fileData.size() / fileChannels;
+  double step = (double)fileSampleRate / sampleRate;
+  size_t outFrames = (size_t)((inFrames - 1) / step) + 1;
+  clip->samples.resize(outFrames * fileChannels);
+  for (size_t i = 0; i < outFrames; ++i) {
+    double position = i * step;
+    size_t k = (size_t)position;
+    size_t next = std::min(k + 1, inFrames - 1);
+    float frac = position - k;
+    for (int channel = 0; channel < fileChannels; ++channel) {
+      float x0 = fileData[k * fileChannels + channel];
+      float x1 = fileData[next * fileChannels + channel];
+      clip->samples[i * fileChannels + channel] = x0 + frac * (x1 - x0);
+    }
+  }
+  return clip;
+}
+
 void FilePlayer::onBrowsePressed() {
   const char *filterPatterns[2] = {"*.wav", "*.aiff"};
   const char *filePath = tinyfd_openFileDialog("Select an audio file", "../assets/", 2,
@@ -70,28 +126,47 @@ void FilePlayer::onBrowsePressed() {
 
 void FilePlayer::process(float **inputBuffer, float **outputBuffer,
                          size_t numSamples) {
-  if (audioData.empty()) {
+  bool looping = loop.advance(numSamples);
+  // A full queue only keeps the old clip playing until the UI catches up
+  if (retired.hasRoom()) {
+    Clip *next = pending.exchange(nullptr, std::memory_order_acq_rel);
+    if (next) {
+      retired.push(active);
+      active = next;
+      playhead = 0;
+    }
+  }
+  if (!active || active->samples.empty()) {
     for (size_t i = 0; i < numChannels; ++i) {
-      memset(outputBuffer[i], 0, numSamples);
+      memset(outputBuffer[i], 0, numSamples * sizeof(float));
     }
     return;
   }
-  size_t sample;
-  for (sample = 0; sample < numSamples; ++sample) {
-    if (playhead >= audioData.size()) {
-      if (loop) {
+  // playhead counts file frames; the file may have more or fewer channels
+  // than the engine
+  size_t fileFrames = active->samples.size() / active->channels;
+  size_t sample = 0;
+  while (sample < numSamples) {
+    if (playhead >= fileFrames) {
+      if (looping) {
         playhead = 0;
       } else {
         break;
       }
     }
-    for (size_t channel = 0; channel < numChannels; ++channel) {
-      outputBuffer[channel][sample] = audioData[playhead++];
+    size_t frames = std::min(numSamples - sample, fileFrames - playhead);
+    if (frames == 0) {
+      break; // Not even one frame in the file
     }
+    Kernels::deinterleave(outputBuffer, sample,
+                          active->samples.data() + playhead * active->channels,
+                          active->channels, numChannels, frames);
+    playhead += frames;
+    sample += frames;
   }
   if (sample != numSamples) {
     for (size_t i = 0; i < numChannels; ++i) {
-      memset(outputBuffer[i] + sample - 1, 0, numSamples - sample);
+      memset(outputBuffer[i] + sample, 0, (numSamples - sample) * sizeof(float));
     }
   }
 }
@@ -1,23 +1,49 @@
 #pragma once
 #include "Processor.hpp"
+#include "../engine/Parameter.hpp"
+#include "../engine/RetireQueue.hpp"
+#include <atomic>
 #include <string>
 #include <vector>
 
 using std::string;
 using std::vector;
 
+// Plays an audio file. The UI thread decodes and resamples a file into a new
+// Clip and publishes it with one atomic exchange; the audio thread picks it
+// up at the start of a buffer and hands the old one back through a retire
+// queue, which render empties. The callback never sees a buffer resized.
 class FilePlayer : public Processor {
+  struct Clip {
+    vector<float> samples; // Interleaved, at the processor's sample rate
+    size_t channels = 1;
+  };
+  static const int MAX_RETIRED = 4;
+
   string path;
-     bool loop;
-     vector<float> audioData;
-     size_t playhead = 0;
+     SteppedParameter<bool> loop{false};
+     // UI side: the file as read, kept to resample when the rate changes
+     vector<float> fileData; // Interleaved
+     int fileSampleRate = 0;
+     int fileChannels = 1;
+
+     std::atomic<Clip *> pending{nullptr}; // Published, not yet picked up
+     RetireQueue<Clip, MAX_RETIRED> retired;
+
+     // Audio side
+     Clip *active = nullptr;
+     size_t playhead = 0; // In frames of active
 
      void onBrowsePressed();
      bool loadAudioFile(const string& filePath);
+     Clip *resample() const;
+     void publish(Clip *clip);
 
  public:
      FilePlayer();
-     virtual ~FilePlayer() override = default;
+     ~FilePlayer() override;
      void render() override;
+     void prepare(float sampleRate, size_t numChannels,
+                  size_t maxBlockSize) override;
      void process(float **inputBuffer, float **outputBuffer, size_t numSamples) override;
 };
@@ -1,4 +1,5 @@
 #include "GainProcessor.hpp"
+#include "../engine/Kernels.hpp"
 #include <imgui.h>
 
 GainProcessor::GainProcessor() : Processor(), gain(1.0f) {}
@@ -9,20 +10,33 @@ void GainProcessor::render() {
   ImGui::Text("Master Gain");
   ImGui::SameLine();
   ImGui::PushID(ImGuiHash);
-  ImGui::SliderFloat("", &gain, 0.0f, 3.0f, "%.4f", ImGuiSliderFlags_Logarithmic);
-  this->setGain(gain);
+  if (ImGui::SliderFloat("", &gain, 0.0f, 3.0f, "%.4f",
+                         ImGuiSliderFlags_Logarithmic)) {
+    this->setGain(gain);
+  }
   ImGui::PopID();
 }
 
-void GainProcessor::setGain(float newGain) { this->gain = newGain; }
+void GainProcessor::setGain(float newGain) { gain.set(newGain); }
+
+float GainProcessor::getGain() { return gain.get(); }
 
-float GainProcessor::getGain() { return this->gain; }
+void GainProcessor::prepare(float sampleRate, size_t numChannels,
+                            size_t maxBlockSize) {
+  Processor::prepare(sampleRate, numChannels, maxBlockSize);
+  gain.prepare(sampleRate, maxBlockSize);
+}
 
 void GainProcessor::process(float **inputBuffer, float **outputBuffer,
                             size_t numSamples) {
+  const float *gains = gain.process(numSamples);
   for (size_t channel = 0; channel < this->numChannels; ++channel) {
-    for (size_t sample = 0; sample < numSamples; ++sample) {
-      outputBuffer[channel][sample] = getGain() * inputBuffer[channel][sample];
+    if (gain.isSmoothing()) {
+      Kernels::scaleRamp(outputBuffer[channel], inputBuffer[channel], gains,
+                         numSamples);
+    } else {
+      Kernels::scale(outputBuffer[channel], inputBuffer[channel],
+                     gain.getCurrent(), numSamples);
     }
   }
 }
@@ -1,8 +1,9 @@
 #pragma once
 #include "Processor.hpp"
+#include "../engine/Parameter.hpp"
 
 class GainProcessor : public Processor {
-  float gain;
+  SmoothedParameter gain;
 
 public:
   GainProcessor();
@@ -10,8 +11,8 @@ public:
   void render() override;
   void process(float **inputBuffer, float **outputBuffer,
                size_t numSamples) override;
+  void prepare(float sampleRate, size_t numChannels,
+               size_t maxBlockSize) override;
   void setGain(float gain);
   float getGain();
-
-
 };
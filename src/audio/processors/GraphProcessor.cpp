@@ -0,0 +1,295 @@
+#include "GraphProcessor.hpp"
+#include "../engine/Kernels.hpp"
+#include "../engine/WorkerPool.hpp"
+#include <algorithm>
+#include <cstring>
+#include <imgui.h>
+#include <stdexcept>
+#include <string>
+
+GraphProcessor::GraphProcessor() : Processor() {}
+
+GraphProcessor::~GraphProcessor() {
+  for (Processor *p : nodes) {
+    delete p;
+  }
+}
+
+int GraphProcessor::addNode(Processor *p) {
+  nodes.push_back(p);
+  return nodes.size() - 1;
+}
+
+void GraphProcessor::connect(int from, int to, float gain) {
+  int numNodes = nodes.size();
+  if (from < INPUT || from >= numNodes || to == INPUT || to < OUTPUT ||
+      to >= numNodes) {
+    throw std::runtime_error("Invalid connection from " +
+                             std::to_string(from) + " to " +
+                             std::to_string(to) + ".");
+  }
+  for (auto &connection : connections) {
+    if (connection.from == from && connection.to == to) {
+      connection.gain += gain;
+      return;
+    }
+  }
+  connections.push_back({from, to, gain});
+}
+
+void GraphProcessor::compile() {
+  // OUTPUT is node n here, INPUT isn't a node
+  size_t n = nodes.size();
+  auto index = [n](int node) { return node == OUTPUT ? n : (size_t)node; };
+  vector<vector<const Connection *>> inputs(n + 1);
+  vector<vector<size_t>> readers(n + 1);
+  vector<size_t> pending(n + 1, 0);
+  for (const auto &connection : connections) {
+    inputs[index(connection.to)].push_back(&connection);
+    if (connection.from != INPUT) {
+      readers[connection.from].push_back(index(connection.to));
+      pending[index(connection.to)]++;
+    }
+  }
+
+  // Kahn's algorithm, a node's wave being one after its latest source's
+  vector<size_t> wave(n + 1, 0);
+  vector<size_t> ready;
+  for (size_t v = 0; v <= n; ++v) {
+    if (pending[v] == 0) {
+      ready.push_back(v);
+    }
+  }
+  size_t visited = 0;
+  while (!ready.empty()) {
+    size_t v = ready.back();
+    ready.pop_back();
+    visited++;
+    for (size_t reader : readers[v]) {
+      wave[reader] = std::max(wave[reader], wave[v] + 1);
+      if (--pending[reader] == 0) {
+        ready.push_back(reader);
+      }
+    }
+  }
+  if (visited != n + 1) {
+    throw std::runtime_error("Processor graph has a cycle.");
+  }
+  // The output mix goes last, on its own
+  size_t lastNodeWave = 0;
+  for (size_t v = 0; v < n; ++v) {
+    lastNodeWave = std::max(lastNodeWave, wave[v]);
+  }
+  wave[n] = n > 0 ? lastNodeWave + 1 : 0;
+  vector<size_t> order(n + 1);
+  for (size_t v = 0; v <= n; ++v) {
+    order[v] = v;
+  }
+  std::stable_sort(order.begin(), order.end(), [&wave](size_t a, size_t b) {
+    return wave[a] < wave[b];
+  });
+
+  vector<size_t> lastRead(n + 1);
+  for (size_t v = 0; v <= n; ++v) {
+    lastRead[v] = wave[v];
+    for (size_t reader : readers[v]) {
+      lastRead[v] = std::max(lastRead[v], wave[reader]);
+    }
+  }
+  // A buffer can be processed in place when no one else reads it in this
+  // wave or later
+  auto onlyReader = [&](size_t owner, size_t v) {
+    for (size_t reader : readers[owner]) {
+      if (reader != v && wave[reader] >= wave[v]) {
+        return false;
+      }
+    }
+    return true;
+  };
+
+  // The last node can write straight into the graph's output when the
+  // output is nothing but that node
+  int direct = -1;
+  if (inputs[n].size() == 1 && inputs[n][0]->from != INPUT &&
+      inputs[n][0]->gain == 1.0f) {
+    size_t v = inputs[n][0]->from;
+    size_t sameWave = std::count(wave.begin(), wave.begin() + n, wave[v]);
+    if (readers[v].size() == 1 && wave[v] == lastNodeWave && sameWave == 1) {
+      direct = v;
+    }
+  }
+
+  steps.clear();
+  waves.clear();
+  numBuffers = 2;
+  vector<int> owner;       // Node whose output each buffer holds, -1 if free
+  vector<int> freeBuffers; // Free since an earlier wave
+  vector<int> holder(n + 1, -1);
+  auto allocate = [&]() {
+    if (!freeBuffers.empty()) {
+      int b = freeBuffers.back();
+      freeBuffers.pop_back();
+      return b;
+    }
+    owner.resize(numBuffers + 1, -1);
+    return (int)numBuffers++;
+  };
+  owner.assign(2, -1);
+  for (size_t i = 0; i < order.size(); ++i) {
+    size_t v = order[i];
+    if (i == 0 || wave[v] != wave[order[i - 1]]) {
+      waves.push_back(steps.size());
+    }
+    vector<Source> sources;
+    for (const Connection *connection : inputs[v]) {
+      int b = connection->from == INPUT ? 0 : holder[connection->from];
+      sources.push_back({b, connection->gain});
+    }
+    auto takeable = [&](const Source &source) {
+      return source.buffer >= 2 && source.gain == 1.0f &&
+             onlyReader(owner[source.buffer], v);
+    };
+
+    if (v == n) {
+      if (direct < 0) {
+        // The graph's input comes first, as it may be the output buffer
+        std::stable_partition(sources.begin(), sources.end(),
+                              [](const Source &s) { return s.buffer == 0; });
+        Step step{nullptr, true, false, sources, 1, 1};
+        steps.push_back(step);
+      }
+    } else {
+      Step step{nodes[v], false, false, {}, 0, 0};
+      if (sources.size() == 1 && sources[0].gain == 1.0f) {
+        step.input = sources[0].buffer;
+        if ((int)v == direct) {
+          step.output = 1;
+        } else {
+          step.output = takeable(sources[0]) ? step.input : allocate();
+        }
+      } else {
+        step.mixes = true;
+        auto taken = std::find_if(sources.begin(), sources.end(), takeable);
+        if (taken != sources.end()) {
+          step.input = taken->buffer;
+          step.accumulate = true;
+          sources.erase(taken);
+        } else {
+          step.input = allocate();
+        }
+        step.mix = sources;
+        step.output = (int)v == direct ? 1 : step.input;
+      }
+      if ((int)v != direct) {
+        owner[step.output] = v;
+        holder[v] = step.output;
+      }
+      steps.push_back(step);
+    }
+
+    // Buffers whose signal has no readers left come free for the next wave
+    if (i + 1 == order.size() || wave[order[i + 1]] != wave[v]) {
+      for (size_t b = 2; b < numBuffers; ++b) {
+        if (owner[b] >= 0 && lastRead[owner[b]] <= wave[v]) {
+          owner[b] = -1;
+          freeBuffers.push_back(b);
+        }
+      }
+    }
+  }
+  waves.push_back(steps.size());
+}
+
+void GraphProcessor::prepare(float sampleRate, size_t numChannels,
+                             size_t maxBlockSize) {
+  Processor::prepare(sampleRate, numChannels, maxBlockSize);
+  compile();
+  pool = BufferArena::current().allocate((numBuffers - 2) * numChannels,
+                                         maxBlockSize);
+  buffers.assign(numBuffers, vector<float *>(numChannels, nullptr));
+  for (size_t b = 2; b < numBuffers; ++b) {
+    for (size_t channel = 0; channel < numChannels; ++channel) {
+      buffers[b][channel] = pool[(b - 2) * numChannels + channel];
+    }
+  }
+  for (Processor *p : nodes) {
+    p->prepare(sampleRate, numChannels, maxBlockSize);
+  }
+  WorkerPool::instance();
+}
+
+size_t GraphProcessor::getNumPoolBuffers() const { return numBuffers - 2; }
+
+float **GraphProcessor::buffer(int index) {
+  if (index == 0) {
+    return graphInput;
+  }
+  if (index == 1) {
+    return graphOutput;
+  }
+  return buffers[index].data();
+}
+
+void GraphProcessor::runStep(const Step &step, size_t numSamples) {
+  float **in = buffer(step.input);
+  if (step.mixes) {
+    for (size_t channel = 0; channel < numChannels; ++channel) {
+      float *destination = in[channel];
+      size_t first = 0;
+      if (!step.accumulate) {
+        if (step.mix.empty()) {
+          memset(destination, 0, numSamples * sizeof(float));
+        } else {
+          Kernels::scale(destination, buffer(step.mix[0].buffer)[channel],
+                         step.mix[0].gain, numSamples);
+        }
+        first = 1;
+      }
+      for (size_t k = first; k < step.mix.size(); ++k) {
+        Kernels::accumulate(destination, buffer(step.mix[k].buffer)[channel],
+                            step.mix[k].gain, numSamples);
+      }
+    }
+  }
+  if (step.processor) {
+    runChild(step.processor, in, buffer(step.output), numSamples);
+  }
+}
+
+void GraphProcessor::runJob(void *graph, size_t index) {
+  auto *self = static_cast<GraphProcessor *>(graph);
+  self->runStep(self->steps[self->waves[self->currentWave] + index],
+                self->currentSamples);
+}
+
+void GraphProcessor::process(float **inputBuffer, float **outputBuffer,
+                             size_t numSamples) {
+  graphInput = inputBuffer;
+  graphOutput = outputBuffer;
+  currentSamples = numSamples;
+  for (size_t w = 0; w + 1 < waves.size(); ++w) {
+    size_t count = waves[w + 1] - waves[w];
+    if (count == 1) {
+      runStep(steps[waves[w]], numSamples);
+    } else {
+      currentWave = w;
+      WorkerPool::instance().run(count, &GraphProcessor::runJob, this);
+    }
+  }
+}
+
+void GraphProcessor::render() {
+  bool first = true;
+  for (const Step &step : steps) {
+    if (!step.processor) {
+      continue;
+    }
+    if (!first) {
+      ImGui::Separator();
+    } else {
+      first = false;
+    }
+    step.processor->renderLoad();
+    step.processor->render();
+  }
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include "Processor.hpp"
+#include "../engine/BufferArena.hpp"
+#include <vector>
+
+using std::vector;
+
+// Processors wired as a directed acyclic graph, with any fan-out and fan-in.
+// A node fed by several connections gets their weighted sum. prepare
+// schedules the nodes in waves of independent ones, which run on the worker
+// pool, and plans which buffers hold which signals: a node whose input dies
+// with it processes in place, and buffers are reused once their last reader
+// is done, so a chain needs no copies at all. Build the graph before
+// prepare; nodes are owned by the graph.
+class GraphProcessor : public Processor {
+public:
+  static const int INPUT = -1;
+  static const int OUTPUT = -2;
+
+private:
+  struct Connection {
+    int from;
+    int to;
+    float gain;
+  };
+  // Buffers are numbered: 0 is the graph's input, 1 its output, the rest
+  // come from the pool
+  struct Source {
+    int buffer;
+    float gain;
+  };
+  struct Step {
+    Processor *processor; // nullptr for the final mix into the output
+    bool mixes = false;   // Sum mix into input before processing
+    bool accumulate = false; // input already holds the first source
+    vector<Source> mix;
+    int input;
+    int output;
+  };
+  vector<Processor *> nodes;
+  vector<Connection> connections;
+  vector<Step> steps;   // In schedule order
+  vector<size_t> waves; // First step of each wave, then steps.size()
+  size_t numBuffers = 2;
+  BufferArena::Buffer pool;        // numChannels per pool buffer
+  vector<vector<float *>> buffers; // Channel pointers per pool buffer
+  float **graphInput = nullptr;
+  float **graphOutput = nullptr;
+  size_t currentWave = 0;
+  size_t currentSamples = 0;
+
+  void compile();
+  float **buffer(int index);
+  void runStep(const Step &step, size_t numSamples);
+  static void runJob(void *graph, size_t index);
+
+public:
+  GraphProcessor();
+  ~GraphProcessor() override;
+  // Returns the node's id, for connect
+  int addNode(Processor *p);
+  // from may be INPUT and to OUTPUT. Connecting the same nodes again adds
+  // to the gain.
+  void connect(int from, int to, float gain = 1.0f);
+  void render() override;
+  void process(float **inputBuffer, float **outputBuffer,
+               size_t numSamples) override;
+  // Throws when the graph has a cycle
+  void prepare(float sampleRate, size_t numChannels,
+               size_t maxBlockSize) override;
+  size_t getNumPoolBuffers() const; // As planned by the last prepare
+};
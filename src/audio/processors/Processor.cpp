@@ -1,14 +1,39 @@
 #include "Processor.hpp"
+#include "../../core/Trace.hpp"
+#include "../engine/RealtimeGuard.hpp"
 #include <cstdlib>
+#include <imgui.h>
+#include <typeinfo>
 
 Processor::Processor(float sampleRate, size_t numChannels)
     : sampleRate(sampleRate), numChannels(numChannels) {
   ImGuiHash = rand();
 }
 
-void Processor::prepare(float sampleRate, size_t numChannels) {
+void Processor::prepare(float sampleRate, size_t numChannels,
+                        size_t maxBlockSize) {
   this->sampleRate = sampleRate;
   this->numChannels = numChannels;
+  this->maxBlockSize = maxBlockSize;
 }
 
 void Processor::reset() {}
+
+void Processor::runChild(Processor *p, float **inputBuffer,
+                         float **outputBuffer, size_t numSamples) {
+  RealtimeGuard::ProcessorScope scope(p);
+  LoadMeter::Scope timer(p->load, numSamples, p->sampleRate);
+  Trace::Span span("process", typeid(*p));
+  p->process(inputBuffer, outputBuffer, numSamples);
+}
+
+LoadMeter &Processor::getLoad() { return load; }
+
+void Processor::renderLoad() {
+  const LoadStats &stats = load.read();
+  if (stats.calls == 0) {
+    return;
+  }
+  ImGui::TextDisabled("DSP %.1f%% avg, %.1f%% p99, %.1f%% max", stats.mean,
+                      stats.p99, stats.max);
+}
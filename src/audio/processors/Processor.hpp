@@ -1,19 +1,33 @@
 #pragma once
 
 // Base class for audio processors
+#include "../engine/LoadMeter.hpp"
 #include <cstddef>
 class Processor {
 
 protected:
   float sampleRate;
   size_t numChannels;
+  size_t maxBlockSize = 2048; // No process call gets more samples than this
   int ImGuiHash = 0;
+  LoadMeter load; // Filled in by the container calling process
+
+  // For containers: p->process, attributed to p in the load meter, the
+  // trace and the realtime guard's report
+  static void runChild(Processor *p, float **inputBuffer, float **outputBuffer,
+                       size_t numSamples);
 
 public:
   Processor(float sampleRate = 44100.0f, size_t numChannels = 2);
   virtual ~Processor() = default;
   virtual void process(float **inputBuffer, float **outputBuffer, size_t numSamples) = 0;
-  virtual void prepare(float sampleRate = 44100.0f, size_t numChannels = 2);
+  // Allocations belong here: process runs on the audio thread. Scratch
+  // buffers come from BufferArena::current().
+  virtual void prepare(float sampleRate = 44100.0f, size_t numChannels = 2,
+                       size_t maxBlockSize = 2048);
   virtual void reset();
   virtual void render() = 0;
+  LoadMeter &getLoad();
+  // One line with the load statistics, for containers to show above render
+  void renderLoad();
 };
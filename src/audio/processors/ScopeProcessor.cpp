@@ -1,7 +1,7 @@
 #include "ScopeProcessor.hpp"
 #include "imgui.h"
+#include "../engine/Kernels.hpp"
 #include <cmath>
-#include <cstring>
 
 ScopeProcessor::ScopeProcessor(size_t bufferSize)
     : Processor(), bufferSize(bufferSize), bufferIndex(0), displayBuffer(bufferSize, 0.0f) {
@@ -10,7 +10,7 @@ ScopeProcessor::ScopeProcessor(size_t bufferSize)
 void ScopeProcessor::process(float **inputBuffer, float **outputBuffer, size_t numSamples) {
     // Copy input to output to pass the audio through unchanged
     for (size_t channel = 0; channel < numChannels; ++channel) {
-        std::memcpy(outputBuffer[channel], inputBuffer[channel], numSamples * sizeof(float));
+        Kernels::copy(outputBuffer[channel], inputBuffer[channel], numSamples);
     }
 
     // Update display buffer with rolling window
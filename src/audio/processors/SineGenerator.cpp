@@ -8,27 +8,43 @@ void SineGenerator::render() {
   ImGui::Text("Amplitude");
   ImGui::SameLine();
   ImGui::PushID(ImGuiHash);
-  ImGui::SliderFloat("", &this->amplitude, 0.0f, 2.0f, "%.4f", ImGuiSliderFlags_Logarithmic);
+  float amplitudeValue = amplitude.get();
+  float frequencyValue = frequency.get();
+  if (ImGui::SliderFloat("", &amplitudeValue, 0.0f, 2.0f, "%.4f",
+                         ImGuiSliderFlags_Logarithmic)) {
+    amplitude.set(amplitudeValue);
+  }
   ImGui::Spacing();
   ImGui::Text("Frequency");
   ImGui::SameLine();
   ImGui::PushID(ImGuiHash + 1);
-  ImGui::SliderFloat("", &this->frequency, 0.0f, 20000.0f, "%.2fHz",
-                     ImGuiSliderFlags_Logarithmic);
+  if (ImGui::SliderFloat("", &frequencyValue, 0.0f, 20000.0f, "%.2fHz",
+                         ImGuiSliderFlags_Logarithmic)) {
+    frequency.set(frequencyValue);
+  }
   ImGui::PopID();
   ImGui::PopID();
 }
 
 void SineGenerator::process(float **inputBuffer, float **outputBuffer,
                             size_t numSamples) {
+  const float *amplitudes = amplitude.process(numSamples);
+  const float *frequencies = frequency.process(numSamples);
   for (size_t sample = 0; sample < numSamples; ++sample) {
-    float value = amplitude * sinf(phase);
+    float value = amplitudes[sample] * sinf(phase);
     outputBuffer[0][sample] = value;
     outputBuffer[1][sample] = value;
-    phase += 2.0f * M_PI * frequency / sampleRate;
+    phase += 2.0f * M_PI * frequencies[sample] / sampleRate;
     if (phase >= 2 * M_PI) {
       phase -= 2 * M_PI;
     }
   }
 }
 SineGenerator::SineGenerator() : Processor() {}
+
+void SineGenerator::prepare(float sampleRate, size_t numChannels,
+                            size_t maxBlockSize) {
+  Processor::prepare(sampleRate, numChannels, maxBlockSize);
+  amplitude.prepare(sampleRate, maxBlockSize);
+  frequency.prepare(sampleRate, maxBlockSize);
+}
@@ -1,9 +1,10 @@
 #pragma once
 #include "Processor.hpp"
+#include "../engine/Parameter.hpp"
 
 class SineGenerator : public Processor {
-  float amplitude = 0.5f;
-  float frequency = 440.0f;
+  SmoothedParameter amplitude{0.5f};
+  SmoothedParameter frequency{440.0f, Ramp::Exponential};
   float phase = 0.0f;
 
 public:
@@ -12,4 +13,6 @@ public:
   void render() override;
   void process(float **inputBuffer, float **outputBuffer,
                size_t numSamples) override;
+  void prepare(float sampleRate, size_t numChannels,
+               size_t maxBlockSize) override;
 };
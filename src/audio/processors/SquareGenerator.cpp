@@ -7,13 +7,19 @@ void SquareGenerator::render() {
   ImGui::Text("Amplitude");
   ImGui::SameLine();
   ImGui::PushID(ImGuiHash);
-  ImGui::SliderFloat("", &this->amplitude, 0.0f, 2.0f, "%.2f");
+  float amplitudeValue = amplitude.get();
+  float frequencyValue = frequency.get();
+  if (ImGui::SliderFloat("", &amplitudeValue, 0.0f, 2.0f, "%.2f")) {
+    amplitude.set(amplitudeValue);
+  }
   ImGui::Spacing();
   ImGui::Text("Frequency");
   ImGui::SameLine();
   ImGui::PushID(ImGuiHash + 1);
-  ImGui::SliderFloat("", &this->frequency, 0.0f, 20000.0f, "%.2fHz",
-                     ImGuiSliderFlags_Logarithmic);
+  if (ImGui::SliderFloat("", &frequencyValue, 0.0f, 20000.0f, "%.2fHz",
+                         ImGuiSliderFlags_Logarithmic)) {
+    frequency.set(frequencyValue);
+  }
   ImGui::PopID();
   ImGui::PopID();
 }
@@ -24,15 +30,24 @@ double signf(double x) {
 
 void SquareGenerator::process(float **inputBuffer, float **outputBuffer,
                             size_t numSamples) {
+  const float *amplitudes = amplitude.process(numSamples);
+  const float *frequencies = frequency.process(numSamples);
   for (size_t sample = 0; sample < numSamples; ++sample) {
-    float val = amplitude * signf(sinf(phase));
+    float val = amplitudes[sample] * signf(sinf(phase));
     for (size_t channel = 0; channel < this->numChannels; ++channel) {
       outputBuffer[channel][sample] = val;
     }
-    phase += 2.0f * M_PI * frequency / sampleRate;
+    phase += 2.0f * M_PI * frequencies[sample] / sampleRate;
     if (phase >= 2 * M_PI) {
       phase -= 2 * M_PI;
     }
   }
 }
 SquareGenerator::SquareGenerator() : Processor() {}
+
+void SquareGenerator::prepare(float sampleRate, size_t numChannels,
+                              size_t maxBlockSize) {
+  Processor::prepare(sampleRate, numChannels, maxBlockSize);
+  amplitude.prepare(sampleRate, maxBlockSize);
+  frequency.prepare(sampleRate, maxBlockSize);
+}
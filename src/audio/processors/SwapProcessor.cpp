@@ -0,0 +1,102 @@
+#include "SwapProcessor.hpp"
+#include "../engine/Kernels.hpp"
+#include <algorithm>
+
+SwapProcessor::SwapProcessor(Processor *initial)
+    : Processor(), latest(initial), active(initial) {}
+
+SwapProcessor::~SwapProcessor() {
+  collect();
+  delete pending.load();
+  delete fadingOut;
+  delete active;
+}
+
+void SwapProcessor::render() {
+  if (latest) {
+    latest->renderLoad();
+    latest->render();
+  }
+}
+
+void SwapProcessor::prepare(float sampleRate, size_t numChannels,
+                            size_t maxBlockSize) {
+  Processor::prepare(sampleRate, numChannels, maxBlockSize);
+  fadeLength = std::max<size_t>(1, sampleRate * FADE_SECONDS);
+  arena = &BufferArena::current();
+  fadeBuffer = arena->allocate(numChannels, maxBlockSize);
+  // Nothing is playing, so a fade can simply end here
+  if (fading) {
+    delete fadingOut;
+    fadingOut = nullptr;
+    fading = false;
+  }
+  if (active) {
+    active->prepare(sampleRate, numChannels, maxBlockSize);
+  }
+  Processor *next = pending.load();
+  if (next) {
+    next->prepare(sampleRate, numChannels, maxBlockSize);
+  }
+}
+
+void SwapProcessor::publish(Processor *p) {
+  {
+    BufferArena::Use use(*arena);
+    p->prepare(sampleRate, numChannels, maxBlockSize);
+  }
+  latest = p;
+  // The audio thread takes pending with an exchange too, so whatever we get
+  // back here was never seen by it
+  delete pending.exchange(p, std::memory_order_acq_rel);
+}
+
+void SwapProcessor::collect() { retired.collect(); }
+
+void SwapProcessor::run(Processor *p, float **inputBuffer,
+                        float **outputBuffer, size_t numSamples) {
+  if (!p) {
+    for (size_t channel = 0; channel < numChannels; ++channel) {
+      Kernels::copy(outputBuffer[channel], inputBuffer[channel], numSamples);
+    }
+    return;
+  }
+  runChild(p, inputBuffer, outputBuffer, numSamples);
+}
+
+void SwapProcessor::process(float **inputBuffer, float **outputBuffer,
+                            size_t numSamples) {
+  if (!fading) {
+    Processor *next = pending.exchange(nullptr, std::memory_order_acq_rel);
+    if (next) {
+      fadingOut = active;
+      active = next;
+      fading = true;
+      fadePosition = 0;
+    }
+  }
+  if (!fading) {
+    run(active, inputBuffer, outputBuffer, numSamples);
+    return;
+  }
+
+  // The old processor gets its own copy of the input, since the new one may
+  // work in place
+  for (size_t channel = 0; channel < numChannels; ++channel) {
+    Kernels::copy(fadeBuffer[channel], inputBuffer[channel], numSamples);
+  }
+  run(fadingOut, fadeBuffer.data(), fadeBuffer.data(), numSamples);
+  run(active, inputBuffer, outputBuffer, numSamples);
+  for (size_t channel = 0; channel < numChannels; ++channel) {
+    Kernels::crossfade(outputBuffer[channel], fadeBuffer[channel],
+                       outputBuffer[channel], fadePosition, fadeLength,
+                       numSamples);
+  }
+  fadePosition += numSamples;
+  // A full queue only keeps the old processor running silently until the
+  // UI catches up
+  if (fadePosition >= fadeLength && retired.push(fadingOut)) {
+    fadingOut = nullptr;
+    fading = false;
+  }
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include "Processor.hpp"
+#include "../engine/BufferArena.hpp"
+#include "../engine/RetireQueue.hpp"
+#include <atomic>
+#include <vector>
+
+using std::vector;
+
+// Holds a processor that the UI can replace while the audio thread runs it.
+// publish hands a prepared processor over with one atomic exchange; the
+// audio thread picks it up at the start of its next buffer and crossfades
+// from the old one. The old processor comes back through a lock-free queue
+// and collect deletes it, away from the audio thread. Passes audio through
+// while empty.
+class SwapProcessor : public Processor {
+  static const int MAX_RETIRED = 16;
+  static constexpr float FADE_SECONDS = 0.01f;
+
+  std::atomic<Processor *> pending{nullptr}; // Published, not yet picked up
+  Processor *latest = nullptr;               // UI side: last one published
+
+  // Audio side
+  Processor *active = nullptr;
+  Processor *fadingOut = nullptr;
+  bool fading = false; // fadingOut may be null, a fade from pass-through
+  size_t fadePosition = 0;
+  size_t fadeLength = 441;
+  BufferArena::Buffer fadeBuffer; // Output of fadingOut, sized in prepare
+  BufferArena *arena = &BufferArena::current(); // Where prepare took from
+
+  // Processors the audio thread is done with
+  RetireQueue<Processor, MAX_RETIRED> retired;
+
+  void run(Processor *p, float **inputBuffer, float **outputBuffer,
+           size_t numSamples);
+
+public:
+  SwapProcessor(Processor *initial = nullptr);
+  ~SwapProcessor() override;
+  void render() override;
+  void process(float **inputBuffer, float **outputBuffer,
+               size_t numSamples) override;
+  // Only while the audio thread isn't running process
+  void prepare(float sampleRate, size_t numChannels,
+               size_t maxBlockSize) override;
+  // UI thread. Takes ownership and prepares p with the current settings.
+  void publish(Processor *p);
+  // UI thread. Deletes the processors the audio thread let go of.
+  void collect();
+};
@@ -1,29 +1,55 @@
 #include "SwitchProcessor.hpp"
 #include "Processor.hpp"
+#include "../engine/Kernels.hpp"
 #include <imgui.h>
 #include <iostream>
 
 
-SwitchProcessor::SwitchProcessor(Processor *p) : processor(p), on(false) {}
+SwitchProcessor::SwitchProcessor(Processor *p) : processor(p) {}
 
 SwitchProcessor::~SwitchProcessor() { delete processor; }
 
 void SwitchProcessor::render() {
   ImGui::Text("Switch Processor");
+  processor->renderLoad();
   processor->render();
   ImGui::Separator();
-  ImGui::Checkbox("On", &on);
+  bool value = on.get();
+  if (ImGui::Checkbox("On", &value)) {
+    on.set(value);
+  }
+}
+
+void SwitchProcessor::prepare(float sampleRate, size_t numChannels,
+                              size_t maxBlockSize) {
+  Processor::prepare(sampleRate, numChannels, maxBlockSize);
+  inputSegment.resize(numChannels);
+  outputSegment.resize(numChannels);
+  processor->prepare(sampleRate, numChannels, maxBlockSize);
 }
 
 void SwitchProcessor::process(float **inputBuffer, float **outputBuffer,
                               size_t numSamples) {
-  if (on) {
-    processor->process(inputBuffer, outputBuffer, numSamples);
-  } else {
-    for (size_t channel = 0; channel < this->numChannels; ++channel) {
-      if (inputBuffer != outputBuffer) {
-        memcpy(outputBuffer[channel], inputBuffer[channel], sizeof(float) * numSamples);
+  // Toggles land on the sample they were set for
+  for (size_t offset = 0; offset < numSamples;) {
+    size_t length = on.nextSegment(numSamples - offset);
+    float **in = inputBuffer;
+    float **out = outputBuffer;
+    if (offset > 0) {
+      for (size_t channel = 0; channel < this->numChannels; ++channel) {
+        inputSegment[channel] = inputBuffer[channel] + offset;
+        outputSegment[channel] = outputBuffer[channel] + offset;
+      }
+      in = inputSegment.data();
+      out = inputBuffer == outputBuffer ? in : outputSegment.data();
+    }
+    if (on.current()) {
+      runChild(processor, in, out, length);
+    } else if (inputBuffer != outputBuffer) {
+      for (size_t channel = 0; channel < this->numChannels; ++channel) {
+        Kernels::copy(out[channel], in[channel], length);
       }
     }
+    offset += length;
   }
 }
@@ -1,12 +1,16 @@
 #pragma once
 #include "Processor.hpp"
+#include "../engine/Parameter.hpp"
 #include <vector>
 
 using std::vector;
 
 class SwitchProcessor : public Processor {
   Processor * processor;
-  bool on;
+  SteppedParameter<bool> on{false};
+  // Channel pointers into the current segment, sized in prepare
+  vector<float *> inputSegment;
+  vector<float *> outputSegment;
 
 public:
   SwitchProcessor(Processor *p);
@@ -14,4 +18,6 @@ public:
   void render() override;
   void process(float **inputBuffer, float **outputBuffer,
                size_t numSamples) override;
+  void prepare(float sampleRate, size_t numChannels,
+               size_t maxBlockSize) override;
 };
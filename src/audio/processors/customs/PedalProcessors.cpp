@@ -5,7 +5,7 @@
 #include "../../../circuits/models/VoltageSourceModel.hpp"
 #include "../../../circuits/models/transistors/BJTs/NPNModel.hpp"
 
-CircuitProcessor *PedalProcessors::FuzzProcessor() {
+CircuitProcessor *PedalProcessors::FuzzProcessor(bool slowSupply) {
   int nodeCount = -1;
   int gnd = nodeCount++;
   int nodeIn = nodeCount++;
@@ -48,7 +48,10 @@ CircuitProcessor *PedalProcessors::FuzzProcessor() {
   c->addComponent(led2);
   c->addComponent(led3);
   int inputIndex = c->addComponent(v1);
-  c->addComponent(v2);
+  int supplyIndex = c->addComponent(v2);
+  if (slowSupply) {
+    c->setSlow(supplyIndex);
+  }
 
   CircuitProcessor *cp = new CircuitProcessor(c);
   cp->setInput(inputIndex);
@@ -2,6 +2,7 @@
 
 class PedalProcessors {
   public:
-  static CircuitProcessor * FuzzProcessor();
+  // slowSupply: solve the 9 V supply at the circuit's decimated rate
+  static CircuitProcessor * FuzzProcessor(bool slowSupply = false);
   static CircuitProcessor * LowPassProcessor(double R, double C);
 };
@@ -1,14 +1,20 @@
 #include "Circuit.hpp"
+#include "../core/Trace.hpp"
 #include "models/ComponentModel.hpp"
 #include "models/VoltageSourceModel.hpp"
 #include <eigen3/Eigen/Dense>
 #include <eigen3/Eigen/src/Core/Matrix.h>
+#include <algorithm>
+#include <cmath>
 #include <stdexcept>
 
 bool Circuit::isNodeGround(int node) { return node < 0; }
 
 int Circuit::addComponent(ComponentModel *comp) {
   components.emplace_back(comp);
+  slow.emplace_back(false);
+  multirateDirty = true;
+  lowRankDirty = true;
   int res = components.size() - 1;
   stamp(G, I, 0, 1); // stamping to update I and G sizes for getLastIndex
   return res;
@@ -19,6 +25,149 @@ Circuit::Circuit(int n) : numNodes(n) {
   I = Eigen::VectorXd::Zero(numNodes);
 }
 
+Circuit::~Circuit() {
+  for (auto comp : components) {
+    delete comp;
+  }
+  for (auto comp : slowCopies) {
+    delete comp;
+  }
+  delete perf.load();
+}
+
+void Circuit::setSlow(int componentIndex, bool isSlow) {
+  if (componentIndex < 0 || componentIndex >= (int)components.size()) {
+    throw std::runtime_error("No component with index " +
+                             std::to_string(componentIndex) + ".");
+  }
+  slow[componentIndex] = isSlow;
+  multirateDirty = true;
+}
+
+void Circuit::setSlowDecimation(int factor) {
+  if (factor < 1) {
+    throw std::runtime_error("Slow decimation factor must be at least 1.");
+  }
+  slowDecimation = factor;
+  multirateDirty = true;
+}
+
+int Circuit::getSlowDecimation() const { return slowDecimation; }
+
+bool Circuit::isSlowUnknown(int unknown) {
+  if (std::find(slow.begin(), slow.end(), true) == slow.end()) {
+    return false;
+  }
+  if (multirateDirty) {
+    buildMultirate();
+  }
+  return std::find(slowPart.rows.begin(), slowPart.rows.end(), unknown) !=
+         slowPart.rows.end();
+}
+
+void Circuit::LinearSystem::resize(int n) {
+  if (x.size() == n) {
+    return;
+  }
+  G = Eigen::MatrixXd::Zero(n, n);
+  I = Eigen::VectorXd::Zero(n);
+  x = Eigen::VectorXd::Zero(n);
+  previous = Eigen::VectorXd::Zero(n);
+  scratch = Eigen::VectorXd::Zero(n);
+  lu = Eigen::FullPivLU<Eigen::MatrixXd>(n, n);
+}
+
+// Same steps as FullPivLU::solve, which allocates its intermediate vector on
+// every call. Singular systems keep Eigen's handling.
+void Circuit::LinearSystem::solve(const Eigen::MatrixXd &A,
+                                  const Eigen::VectorXd &b,
+                                  PerfCounters *counters) {
+  factorize(A, counters);
+  solveFactored(b);
+}
+
+void Circuit::LinearSystem::factorize(const Eigen::MatrixXd &A,
+                                      PerfCounters *counters) {
+  Trace::DetailSpan span("factorize");
+  PerfCounters::Scope counting(counters, PERF_FACTORIZE);
+  lu.compute(A);
+}
+
+void Circuit::LinearSystem::solveFactored(
+    const Eigen::Ref<const Eigen::VectorXd> &b) {
+  Trace::DetailSpan span("solve");
+  if (lu.rank() < lu.rows()) {
+    x = lu.solve(b);
+    return;
+  }
+  scratch.noalias() = lu.permutationP() * b;
+  lu.matrixLU().triangularView<Eigen::UnitLower>().solveInPlace(scratch);
+  lu.matrixLU().triangularView<Eigen::Upper>().solveInPlace(scratch);
+  x.noalias() = lu.permutationQ() * scratch;
+}
+
+void Circuit::Subsystem::resize(int numUnknowns) {
+  G = Eigen::MatrixXd::Zero(numUnknowns, numUnknowns);
+  I = Eigen::VectorXd::Zero(numUnknowns);
+  system.resize(rows.size());
+}
+
+Circuit::NewtonResult Circuit::Subsystem::solve(Eigen::VectorXd &V, double t,
+                                                double dt, int maxIterations,
+                                                PerfCounters *counters) {
+  const double CONVERGENCE_THRESHOLD = 1e-5;
+  NewtonResult result;
+  size_t n = rows.size();
+  for (int iter = 0; iter < maxIterations && !result.converged; iter++) {
+    result.iterations++;
+    G.setZero();
+    I.setZero();
+    {
+      Trace::DetailSpan stamping(span);
+      PerfCounters::Scope counting(counters, PERF_STAMP);
+      for (auto comp : models) {
+        comp->stamp(G, I, t, dt);
+      }
+    }
+    // Known unknowns move to the right side
+    for (size_t i = 0; i < n; ++i) {
+      int row = rows[i];
+      system.I(i) = I(row);
+      for (size_t j = 0; j < n; ++j) {
+        system.G(i, j) = G(row, rows[j]);
+      }
+      for (int k : known) {
+        system.I(i) -= G(row, k) * V(k);
+      }
+    }
+    system.solve(system.G, system.I, counters);
+    if (iter > 0) {
+      result.error = (system.x - system.previous).norm() / system.x.norm();
+      result.converged = (result.error < CONVERGENCE_THRESHOLD);
+    }
+    system.previous = system.x;
+    for (size_t i = 0; i < n; ++i) {
+      V(rows[i]) = system.x(i);
+    }
+    PerfCounters::Scope counting(counters, PERF_UPDATE_STATE);
+    for (auto comp : models) {
+      comp->updateState(V, I);
+    }
+  }
+  return result;
+}
+
+void Circuit::prepare() {
+  system.resize(getLastIndex());
+  if (lowRankDirty) {
+    buildLowRank();
+  }
+  if (multirateDirty &&
+      std::find(slow.begin(), slow.end(), true) != slow.end()) {
+    buildMultirate();
+  }
+}
+
 void Circuit::solveTransient(double start, double dt, size_t numSamples,
                              int inputNode, int outputL, int outputR,
                              float **inputBuffer, float **outputBuffer) {
@@ -39,43 +188,422 @@ void Circuit::solveTransient(double start, double dt, size_t numSamples,
   if (!v) {
     throw std::runtime_error("Input is not a voltage source.\n");
   }
-  Eigen::VectorXd V;
+  if (std::find(slow.begin(), slow.end(), true) != slow.end()) {
+    solveMultirate(start, dt, numSamples, v, outputL, outputR, inputBuffer,
+                   outputBuffer);
+    return;
+  }
+  prepare();
+  beginParameterRamps(dt);
+  beginDeadline();
 
+  PerfCounters *counters = activePerfCounters();
+  uint64_t factorizations = 0;
+  uint64_t degraded = 0;
   for (size_t i = 0; i < numSamples; ++i) {
-    // Initialize state from previous timestep
-    Eigen::VectorXd V_prev = V; // Store previous solution
-
-    const int MAX_ITERATIONS = 10;
     const double CONVERGENCE_THRESHOLD = 1e-5;
+    auto sampleStart = SolverStats::Clock::now();
+    if (!ramping.empty()) {
+      stepParameterRamps();
+    }
     bool converged = false;
     double error = 0;
-    for (int iter = 0; iter < MAX_ITERATIONS && !converged; iter++) {
+    int iterations = 0;
+    for (int iter = 0; iter < iterationLimit() && !converged; iter++) {
+      iterationCount++;
+      iterations++;
       G.setZero();
       I.setZero();
       v->setVoltage(inputBuffer[0][i]);
-      stamp(G, I, t, dt);
-      Eigen::VectorXd V_next = G.fullPivLu().solve(I);
+      {
+        Trace::DetailSpan span("stamp");
+        PerfCounters::Scope counting(counters, PERF_STAMP);
+        if (lowRank.models.empty()) {
+          stamp(G, I, t, dt);
+        } else {
+          stampBase(G, I, t, dt);
+        }
+      }
+      if (lowRank.models.empty()) {
+        system.solve(G, I, counters);
+        factorizations++;
+      } else if (solveLowRank(G, I, counters)) {
+        factorizations++;
+      }
       if (iter > 0) {
-        error = (V_next - V_prev).norm() / V_next.norm();
+        error = (system.x - system.previous).norm() / system.x.norm();
         converged = (error < CONVERGENCE_THRESHOLD);
       }
-      V_prev = V_next;
-      updateState(V_next);
+      system.previous.swap(system.x);
+      PerfCounters::Scope counting(counters, PERF_UPDATE_STATE);
+      updateState(system.previous);
     }
-    // if (!converged) {
-    //   std::cout << "Did not converge... (" << error << ")" << std::endl;
-    // }
+    auto sampleEnd = SolverStats::Clock::now();
+    stats.recordSample(iterations, converged, error, sampleEnd - sampleStart,
+                       effort == EFFORT_FULL);
+    degraded += effort != EFFORT_FULL;
+    checkDeadline(sampleEnd, numSamples - i - 1);
+
+    // Final solution for this timestep
+    outputBuffer[0][i] = system.previous(outputL);
+    outputBuffer[1][i] = system.previous(outputR);
+
+    t += dt;
+  }
+  stats.recordBuffer(factorizations, degraded);
+}
+
+void Circuit::setDeadline(double seconds) { deadline = seconds; }
+
+void Circuit::beginDeadline() {
+  effort = EFFORT_FULL;
+  effortSamples = 0;
+  if (deadline > 0.0) {
+    bufferStart = effortStart = SolverStats::Clock::now();
+  }
+}
+
+// The samples left are projected at the pace of those solved since the last
+// change of effort, so a cheaper effort gets its own chance to catch up
+void Circuit::checkDeadline(SolverStats::Clock::time_point now,
+                            size_t remaining) {
+  if (deadline <= 0.0 || effort == EFFORT_LINEARIZED || remaining == 0) {
+    return;
+  }
+  effortSamples++;
+  double elapsed = std::chrono::duration<double>(now - bufferStart).count();
+  // One slow sample, a full-effort one on the iteration cap, is no pace
+  if (effortSamples < MIN_PACE_SAMPLES && elapsed < deadline) {
+    return;
+  }
+  double pace =
+      std::chrono::duration<double>(now - effortStart).count() / effortSamples;
+  if (elapsed + pace * remaining > deadline) {
+    effort = (Effort)(effort + 1);
+    effortStart = now;
+    effortSamples = 0;
+  }
+}
+
+int Circuit::iterationLimit() const {
+  switch (effort) {
+  case EFFORT_FULL:
+    return MAX_ITERATIONS;
+  case EFFORT_FEW_ITERATIONS:
+    return FEW_ITERATIONS;
+  default:
+    return 1;
+  }
+}
+
+void Circuit::buildLowRank() {
+  lowRank.isLowRank.assign(components.size(), false);
+  lowRank.models.clear();
+  size_t k = 0;
+  for (size_t i = 0; i < components.size(); ++i) {
+    int count = components[i]->getNumConductances();
+    if (count > 0) {
+      lowRank.isLowRank[i] = true;
+      lowRank.models.emplace_back(components[i]);
+      k += count;
+    }
+  }
+  int n = getLastIndex();
+  lowRank.terms.resize(k);
+  lowRank.U = Eigen::MatrixXd::Zero(n, k);
+  Conductance *term = lowRank.terms.data();
+  for (auto model : lowRank.models) {
+    model->getConductances(term);
+    term += model->getNumConductances();
+  }
+  for (size_t j = 0; j < k; ++j) {
+    const Conductance &c = lowRank.terms[j];
+    if (!isNodeGround(c.node1)) {
+      lowRank.U(c.node1, j) = 1.0;
+    }
+    if (!isNodeGround(c.node2)) {
+      lowRank.U(c.node2, j) = -1.0;
+    }
+  }
+  lowRank.Z = Eigen::MatrixXd::Zero(n, k);
+  lowRank.UtZ = Eigen::MatrixXd::Zero(k, k);
+  lowRank.base = Eigen::MatrixXd::Zero(n, n);
+  lowRank.capacitance.resize(k);
+  lowRank.factored = false;
+  lowRank.changing = false;
+  lowRankDirty = false;
+}
+
+void Circuit::stampBase(Eigen::MatrixXd &outG, Eigen::VectorXd &outI,
+                        double t, double dt) {
+  for (size_t i = 0; i < components.size(); ++i) {
+    if (!lowRank.isLowRank[i]) {
+      components[i]->stamp(outG, outI, t, dt);
+    }
+  }
+}
+
+// Potentiometers and the like stay out of A. Its factorization is kept for
+// as long as A doesn't change, which is every sample of a linear circuit,
+// and they come in through the Woodbury identity:
+//   (A + U D U^T)^-1 b = y - Z (D^-1 + U^T Z)^-1 U^T y
+// with y = A^-1 b, Z = A^-1 U, the columns of U the node pairs and D their
+// conductances. Moving a wiper then costs a solve the size of the number of
+// conductances instead of a refactorization. Returns whether it factorized.
+bool Circuit::solveLowRank(const Eigen::MatrixXd &A, const Eigen::VectorXd &b,
+                           PerfCounters *counters) {
+  // Compared even after a full solve, so that the solver goes back to the
+  // update once A settles
+  bool changed = A != lowRank.base;
+  bool wasChanging = lowRank.changing;
+  lowRank.changing = changed;
+  if (changed) {
+    lowRank.base = A;
+    lowRank.factored = false;
+  }
+
+  Conductance *term = lowRank.terms.data();
+  for (auto model : lowRank.models) {
+    model->getConductances(term);
+    term += model->getNumConductances();
+  }
+
+  // While nonlinear components keep changing A, factorizing it and updating
+  // the result costs more than factorizing everything
+  if (changed && wasChanging) {
+    solveStamped(A, b, counters);
+    return true;
+  }
+  bool factorized = false;
+  if (!lowRank.factored) {
+    system.factorize(A, counters);
+    factorized = true;
+    lowRank.factored = true;
+    lowRank.invertible = system.lu.rank() == A.rows();
+    if (lowRank.invertible) {
+      for (int j = 0; j < lowRank.U.cols(); ++j) {
+        system.solveFactored(lowRank.U.col(j));
+        lowRank.Z.col(j) = system.x;
+      }
+      lowRank.UtZ.noalias() = lowRank.U.transpose() * lowRank.Z;
+    }
+  }
+  if (!lowRank.invertible) {
+    // Some node only connects through these conductances, so A can't be
+    // solved on its own
+    solveStamped(A, b, counters);
+    return true;
+  }
+
+  LinearSystem &capacitance = lowRank.capacitance;
+  system.solveFactored(b);
+  capacitance.G = lowRank.UtZ;
+  for (int j = 0; j < lowRank.U.cols(); ++j) {
+    capacitance.G(j, j) += 1.0 / lowRank.terms[j].g;
+  }
+  capacitance.I.noalias() = lowRank.U.transpose() * system.x;
+  capacitance.lu.compute(capacitance.G);
+  capacitance.solveFactored(capacitance.I);
+  system.x.noalias() -= lowRank.Z * capacitance.x;
+  return factorized;
+}
+
+void Circuit::solveStamped(const Eigen::MatrixXd &A, const Eigen::VectorXd &b,
+                           PerfCounters *counters) {
+  system.G = A;
+  for (int j = 0; j < lowRank.U.cols(); ++j) {
+    system.G.noalias() += lowRank.terms[j].g * lowRank.U.col(j) *
+                          lowRank.U.col(j).transpose();
+  }
+  system.solve(system.G, b, counters);
+  // system.lu no longer holds A
+  lowRank.factored = false;
+}
+
+void Circuit::buildMultirate() {
+  for (auto comp : slowCopies) {
+    delete comp;
+  }
+  slowCopies.clear();
+  slowCopyOf.assign(components.size(), nullptr);
+  fastPart.models.clear();
+  slowPart.models.clear();
+  fastPart.rows.clear();
+  slowPart.rows.clear();
+
+  int n = getLastIndex();
+  vector<bool> isSlowUnknown(n, false);
+  for (size_t i = 0; i < components.size(); ++i) {
+    if (slow[i]) {
+      for (int u : components[i]->getUnknowns()) {
+        isSlowUnknown[u] = true;
+      }
+    }
+  }
+  for (int u = 0; u < n; ++u) {
+    (isSlowUnknown[u] ? slowPart.rows : fastPart.rows).emplace_back(u);
+  }
+  fastPart.known = slowPart.rows;
+  slowPart.known = fastPart.rows;
+  slowPart.span = "stamp slow";
+
+  // Fast models touching the slow subnetwork also feed its KCL, through a
+  // copy of their own that is stamped at the slow rate.
+  for (size_t i = 0; i < components.size(); ++i) {
+    if (slow[i]) {
+      slowPart.models.emplace_back(components[i]);
+      continue;
+    }
+    fastPart.models.emplace_back(components[i]);
+    for (int u : components[i]->getUnknowns()) {
+      if (isSlowUnknown[u]) {
+        ComponentModel *copy = components[i]->clone();
+        slowCopies.emplace_back(copy);
+        slowCopyOf[i] = copy;
+        slowPart.models.emplace_back(copy);
+        break;
+      }
+    }
+  }
+
+  slowPrev = Eigen::VectorXd::Zero(n);
+  slowNext = Eigen::VectorXd::Zero(n);
+  slowState = Eigen::VectorXd::Zero(n);
+  lastV = Eigen::VectorXd::Zero(n);
+  fastPart.resize(n);
+  slowPart.resize(n);
+  slowPhase = 0;
+  slowSeeded = false;
+  checkedInput = nullptr;
+  multirateDirty = false;
+}
+
+// Solves the whole circuit at full rate for the first sample. The slow
+// unknowns then start interpolating from there instead of from 0 V, which
+// would add a startup transient of the size of the supply.
+void Circuit::seedMultirate(double t, double dt, VoltageSourceModel *input,
+                            float value, PerfCounters *counters) {
+  const double CONVERGENCE_THRESHOLD = 1e-5;
+  input->setVoltage(value);
+  bool converged = false;
+  for (int iter = 0; iter < MAX_ITERATIONS && !converged; iter++) {
+    G.setZero();
+    I.setZero();
+    stamp(G, I, t, dt);
+    system.solve(G, I, counters);
+    if (iter > 0) {
+      double error = (system.x - system.previous).norm() / system.x.norm();
+      converged = (error < CONVERGENCE_THRESHOLD);
+    }
+    system.previous.swap(system.x);
+    updateState(system.previous);
+  }
+  lastV = system.previous;
+  slowNext = lastV;
+  for (auto copy : slowCopies) {
+    copy->updateState(lastV, I);
+  }
+  slowPhase = 0;
+  slowSeeded = true;
+}
+
+void Circuit::solveMultirate(double start, double dt, size_t numSamples,
+                             VoltageSourceModel *input, int outputL,
+                             int outputR, float **inputBuffer,
+                             float **outputBuffer) {
+  if (multirateDirty) {
+    buildMultirate();
+  }
+  if (input != checkedInput) {
+    for (int u : input->getUnknowns()) {
+      if (std::find(slowPart.rows.begin(), slowPart.rows.end(), u) !=
+          slowPart.rows.end()) {
+        throw std::runtime_error(
+            "Input can't be part of the slow subnetwork.");
+      }
+    }
+    checkedInput = input;
+  }
+
+  double t = start;
+  Eigen::VectorXd &V = lastV;
+  Eigen::VectorXd &S = slowState;
+  beginParameterRamps(dt);
+  beginDeadline();
+  PerfCounters *counters = activePerfCounters();
+  uint64_t factorizations = 0;
+  uint64_t degraded = 0;
+  if (!slowSeeded && numSamples > 0) {
+    seedMultirate(t, dt, input, inputBuffer[0][0], counters);
+  }
+
+  for (size_t i = 0; i < numSamples; ++i) {
+    auto sampleStart = SolverStats::Clock::now();
+    if (!ramping.empty()) {
+      stepParameterRamps();
+    }
+    if (slowPhase == 0) {
+      // Step the slow subnetwork one decimated step ahead, holding the fast
+      // unknowns at their latest values.
+      double slowDt = dt * slowDecimation;
+      S = V;
+      factorizations +=
+          slowPart.solve(S, t, slowDt, iterationLimit(), counters).iterations;
+      slowPrev = slowNext;
+      slowNext = S;
+    }
+
+    // Slow unknowns are interpolated across the decimated step
+    slowPhase++;
+    double alpha = (double)slowPhase / slowDecimation;
+    for (int u : slowPart.rows) {
+      V(u) = slowPrev(u) + alpha * (slowNext(u) - slowPrev(u));
+    }
+    if (slowPhase == (size_t)slowDecimation) {
+      slowPhase = 0;
+    }
+
+    input->setVoltage(inputBuffer[0][i]);
+    NewtonResult result = fastPart.solve(V, t, dt, iterationLimit(), counters);
+    iterationCount += result.iterations;
+
+    // Slow steps are part of the sample that triggered them
+    factorizations += result.iterations;
+    auto sampleEnd = SolverStats::Clock::now();
+    stats.recordSample(result.iterations, result.converged, result.error,
+                       sampleEnd - sampleStart, effort == EFFORT_FULL);
+    degraded += effort != EFFORT_FULL;
+    checkDeadline(sampleEnd, numSamples - i - 1);
 
-    V = V_prev; // Final solution for this timestep
     outputBuffer[0][i] = V(outputL);
     outputBuffer[1][i] = V(outputR);
-
     t += dt;
   }
+  stats.recordBuffer(factorizations, degraded);
 }
 
 int Circuit::getNumStates() { return numNodes; }
 
+size_t Circuit::getIterationCount() const { return iterationCount; }
+
+SolverStats &Circuit::getStats() { return stats; }
+
+void Circuit::setPerfCounters(bool enabled) {
+  if (enabled && !perf.load()) {
+    perf.store(new PerfCounters(), std::memory_order_release);
+  }
+  perfEnabled = enabled;
+}
+
+PerfCounters *Circuit::getPerfCounters() { return perf.load(); }
+
+PerfCounters *Circuit::activePerfCounters() {
+  if (!perfEnabled.load(std::memory_order_relaxed)) {
+    return nullptr;
+  }
+  return perf.load(std::memory_order_acquire);
+}
+
 void Circuit::stamp(Eigen::MatrixXd &outG, Eigen::VectorXd &outI, double t,
                     double dt) {
   for (auto comp : components) {
@@ -91,8 +619,80 @@ void Circuit::updateState(const Eigen::VectorXd &V) {
 
 int Circuit::getLastIndex() { return I.size(); }
 
+const vector<ComponentModel *> &Circuit::getComponents() const {
+  return components;
+}
+
 void Circuit::initializeState() {
   for (auto comp : components) {
     comp->initializeState();
   }
+  slowPhase = 0;
+  slowSeeded = false;
+}
+
+CircuitParameter *Circuit::getParameter(int componentIndex,
+                                        const std::string &name) {
+  if (componentIndex < 0 || componentIndex >= (int)components.size()) {
+    throw std::runtime_error("No component with index " +
+                             std::to_string(componentIndex) + ".");
+  }
+  ComponentModel *model = components[componentIndex];
+  int index = model->getParameterIndex(name);
+  if (index < 0) {
+    return nullptr;
+  }
+  for (auto &p : parameters) {
+    if (p->component == componentIndex && p->index == index) {
+      return p.get();
+    }
+  }
+  parameters.emplace_back(
+      new CircuitParameter(componentIndex, index, model->getParameter(index),
+                           model->isParameterLogarithmic(index)));
+  ramping.reserve(parameters.size());
+  return parameters.back().get();
+}
+
+// Targets are only read here, so a whole buffer sees one consistent ramp
+void Circuit::beginParameterRamps(double dt) {
+  for (auto &p : parameters) {
+    double target = p->target.load(std::memory_order_relaxed);
+    if (target == p->rampTarget) {
+      continue;
+    }
+    if (p->remaining == 0) {
+      ramping.push_back(p.get());
+    }
+    p->rampTarget = target;
+    p->remaining = std::max<size_t>(1, SMOOTHING_SECONDS / dt);
+    p->geometric = p->logarithmic && p->current > 0 && target > 0;
+    p->step = p->geometric
+                  ? std::pow(target / p->current, 1.0 / p->remaining)
+                  : (target - p->current) / p->remaining;
+  }
+}
+
+void Circuit::stepParameterRamps() {
+  for (size_t i = 0; i < ramping.size();) {
+    CircuitParameter *p = ramping[i];
+    p->remaining--;
+    if (p->remaining == 0) {
+      p->current = p->rampTarget;
+    } else if (p->geometric) {
+      p->current *= p->step;
+    } else {
+      p->current += p->step;
+    }
+    components[p->component]->setParameter(p->index, p->current);
+    if (!slowCopyOf.empty() && slowCopyOf[p->component]) {
+      slowCopyOf[p->component]->setParameter(p->index, p->current);
+    }
+    if (p->remaining == 0) {
+      ramping[i] = ramping.back();
+      ramping.pop_back();
+    } else {
+      ++i;
+    }
+  }
 }
@@ -1,7 +1,15 @@
 #pragma once
 
+#include "CircuitParameter.hpp"
+#include "PerfCounters.hpp"
+#include "SolverStats.hpp"
 #include "models/ComponentModel.hpp"
+#include <eigen3/Eigen/Dense>
 #include <eigen3/Eigen/Sparse>
+#include <memory>
+#include <string>
+
+class VoltageSourceModel;
 
 class Circuit {
   vector<ComponentModel *> components;
@@ -9,17 +17,171 @@ class Circuit {
   vector<int> data;
   Eigen::MatrixXd G;
   Eigen::VectorXd I;
+  size_t iterationCount = 0; // Newton iterations since construction
+  SolverStats stats;
+  // Allocated the first time hardware counters are turned on, then kept
+  std::atomic<PerfCounters *> perf{nullptr};
+  std::atomic<bool> perfEnabled{false};
+
+  vector<std::unique_ptr<CircuitParameter>> parameters;
+  vector<CircuitParameter *> ramping; // Capacity reserved for all of them
+  static constexpr double SMOOTHING_SECONDS = 0.02;
+
+public:
+  // A linear system with its work buffers, sized once so that solving it
+  // again doesn't touch the heap. Also used by the relaxation solver.
+  struct LinearSystem {
+    Eigen::MatrixXd G;
+    Eigen::VectorXd I;
+    Eigen::VectorXd x;
+    Eigen::VectorXd previous;
+    Eigen::VectorXd scratch;
+    Eigen::FullPivLU<Eigen::MatrixXd> lu;
+    void resize(int n);
+    void solve(const Eigen::MatrixXd &A, const Eigen::VectorXd &b,
+               PerfCounters *counters = nullptr);
+    void factorize(const Eigen::MatrixXd &A, PerfCounters *counters = nullptr);
+    // x = A^-1 b, A being the matrix last factorized
+    void solveFactored(const Eigen::Ref<const Eigen::VectorXd> &b);
+  };
+
+  struct NewtonResult {
+    int iterations = 0;
+    bool converged = false;
+    double error = 0.0; // Relative update at the last iteration
+  };
+
+  // Some of the unknowns solved by Newton's method, the others held at known
+  // values. The multirate and waveform-relaxation solvers are built on it.
+  struct Subsystem {
+    vector<ComponentModel *> models; // Stamped into G and I
+    vector<int> rows;                // Unknowns solved for
+    vector<int> known;               // Unknowns read from V
+    const char *span = "stamp";      // Trace label of the stamps
+    Eigen::MatrixXd G;               // Over all the unknowns
+    Eigen::VectorXd I;
+    LinearSystem system; // Restricted to rows
+    void resize(int numUnknowns);
+    // Iterates at time t until the update is small or maxIterations. The
+    // solution goes to V's rows and to system.previous.
+    NewtonResult solve(Eigen::VectorXd &V, double t, double dt,
+                       int maxIterations, PerfCounters *counters = nullptr);
+  };
+
+  // Newton iterations per sample at full effort. Junction limiting in the
+  // transistor models trades step size for iterations: at 10, high-frequency
+  // input into the fuzz still stops short.
+  static const int MAX_ITERATIONS = 20;
+  static_assert(MAX_ITERATIONS < SolverSnapshot::NUM_BINS,
+                "the iteration histogram must tell every count apart");
+
+private:
+  LinearSystem system;
+
+  // Components applied as a low-rank update to the factorization of the
+  // rest of the circuit, see solveLowRank
+  struct LowRankUpdate {
+    vector<bool> isLowRank; // By component
+    vector<ComponentModel *> models;
+    vector<Conductance> terms;
+    Eigen::MatrixXd U;   // A column per conductance, +1 and -1 on its nodes
+    Eigen::MatrixXd Z;   // A^-1 U
+    Eigen::MatrixXd UtZ; // U^T A^-1 U
+    Eigen::MatrixXd base; // The last A, which system.lu holds when factored
+    bool factored = false; // system.lu holds base, if invertible
+    bool invertible = false;
+    bool changing = false; // base changed at the last solve
+    LinearSystem capacitance; // D^-1 + U^T A^-1 U, one row per conductance
+  };
+  LowRankUpdate lowRank;
+  bool lowRankDirty = true;
+
+  // Multi-rate: components marked slow are solved every slowDecimation
+  // samples, together with every unknown they touch. The fast system reads
+  // those unknowns as known voltages interpolated between two slow steps.
+  vector<bool> slow;
+  int slowDecimation = 8;
+  bool multirateDirty = true;
+  Subsystem fastPart; // Known: the slow unknowns
+  Subsystem slowPart; // Known: the fast unknowns
+  vector<ComponentModel *> slowCopies; // Fast models seen by the slow system
+  vector<ComponentModel *> slowCopyOf; // By component, nullptr if none
+  Eigen::VectorXd slowPrev; // Full solution at the last two slow steps
+  Eigen::VectorXd slowNext;
+  Eigen::VectorXd slowState;
+  Eigen::VectorXd lastV;
+  size_t slowPhase = 0;
+  bool slowSeeded = false; // slowNext holds a full solve to start from
+  const VoltageSourceModel *checkedInput = nullptr; // Known not to be slow
+
+  // Cheaper ways to step, taken for the rest of a buffer that would
+  // otherwise miss its deadline
+  enum Effort { EFFORT_FULL, EFFORT_FEW_ITERATIONS, EFFORT_LINEARIZED };
+  static const int FEW_ITERATIONS = 2;
+  // Samples solved at an effort before their pace may lower it
+  static const size_t MIN_PACE_SAMPLES = 8;
+  double deadline = 0.0;
+  Effort effort = EFFORT_FULL;
+  SolverStats::Clock::time_point bufferStart;
+  SolverStats::Clock::time_point effortStart;
+  size_t effortSamples = 0;
+
+  void buildMultirate();
+  void seedMultirate(double t, double dt, VoltageSourceModel *input,
+                     float value, PerfCounters *counters);
+  void solveMultirate(double start, double dt, size_t numSamples,
+                      VoltageSourceModel *input, int outputL, int outputR,
+                      float **inputBuffer, float **outputBuffer);
+  PerfCounters *activePerfCounters();
+  void buildLowRank();
+  void stampBase(Eigen::MatrixXd &outG, Eigen::VectorXd &outI, double t,
+                 double dt);
+  bool solveLowRank(const Eigen::MatrixXd &A, const Eigen::VectorXd &b,
+                    PerfCounters *counters);
+  void solveStamped(const Eigen::MatrixXd &A, const Eigen::VectorXd &b,
+                    PerfCounters *counters);
+  void beginParameterRamps(double dt);
+  void stepParameterRamps();
+  void beginDeadline();
+  // After each sample, with the number still to solve in the buffer
+  void checkDeadline(SolverStats::Clock::time_point now, size_t remaining);
+  int iterationLimit() const;
 
 public:
   Circuit(int nodes);
-  int addComponent(ComponentModel *comp);
+  ~Circuit();
+  int addComponent(ComponentModel *comp); // Takes ownership
+  void setSlow(int componentIndex, bool isSlow = true);
+  void setSlowDecimation(int factor);
+  int getSlowDecimation() const;
+  // Whether a slow component touches this node or branch current
+  bool isSlowUnknown(int unknown);
+  // Sizes the solver's buffers for the current components. solveTransient
+  // calls it too, but only allocates when something changed.
+  void prepare();
   void solveTransient(double start, double dt, size_t numSamples, int inputNode,
                       int outputL, int outputR, float **inputBuffer,
                       float **outputBuffer);
+  // Time one solveTransient call may take, 0 for no limit. When the buffer
+  // won't be done in time at full quality, the rest of it gets fewer Newton
+  // iterations per sample, then a single one: the circuit linearized around
+  // the last sample.
+  void setDeadline(double seconds);
   int getNumStates();
   static bool isNodeGround(int node);
   void stamp(Eigen::MatrixXd &outG, Eigen::VectorXd &outI, double t, double dt);
   void updateState(const Eigen::VectorXd &V);
   int getLastIndex();
   void initializeState();
+  const vector<ComponentModel *> &getComponents() const;
+  size_t getIterationCount() const;
+  SolverStats &getStats();
+  // Hardware counters around stamp, factorization and updateState, see
+  // PerfCounters. Not for the audio thread.
+  void setPerfCounters(bool enabled);
+  PerfCounters *getPerfCounters(); // nullptr if never turned on
+  // Handle to a value of a component that can change while the circuit
+  // runs, nullptr if the component has no such parameter. Not while the
+  // circuit runs, the handles themselves may be used anytime.
+  CircuitParameter *getParameter(int componentIndex, const std::string &name);
 };
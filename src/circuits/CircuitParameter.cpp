@@ -0,0 +1,26 @@
+#include "CircuitParameter.hpp"
+#include <cmath>
+#include <stdexcept>
+#include <string>
+
+CircuitParameter::CircuitParameter(int component, int index, double value,
+                                   bool logarithmic)
+    : component(component), index(index), logarithmic(logarithmic),
+      target(value), rampTarget(value), current(value) {}
+
+void CircuitParameter::set(double value) {
+  if (!std::isfinite(value)) {
+    throw std::runtime_error("Parameter value must be finite.");
+  }
+  if (logarithmic && value <= 0) {
+    throw std::runtime_error("Parameter value must be positive, got " +
+                             std::to_string(value) + ".");
+  }
+  target.store(value, std::memory_order_relaxed);
+}
+
+double CircuitParameter::get() const {
+  return target.load(std::memory_order_relaxed);
+}
+
+bool CircuitParameter::isLogarithmic() const { return logarithmic; }
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+// A component value that the UI changes while the circuit runs. set only
+// stores the target; the solving thread picks it up at the start of its next
+// buffer and ramps the component to it geometrically, sample by sample,
+// keeping the rest of the circuit's state. Linear parameters, such as a
+// potentiometer's position or a source's voltage, ramp linearly, as do
+// ramps from or to a value that isn't positive.
+class CircuitParameter {
+  friend class Circuit;
+
+  int component; // Index in the circuit
+  int index;     // ComponentModel parameter index
+  bool logarithmic;
+  std::atomic<double> target;
+
+  // Solving thread
+  double rampTarget;
+  double current;
+  double step = 0.0; // Factor per sample, or increment when linear
+  bool geometric = false; // This ramp's step is a factor
+  size_t remaining = 0; // Samples left in the ramp
+
+public:
+  CircuitParameter(int component, int index, double value, bool logarithmic);
+  // Any thread. Logarithmic values must be positive.
+  void set(double value);
+  double get() const; // Last value set
+  bool isLogarithmic() const;
+};
@@ -5,6 +5,7 @@
 #include "factories/DiodeFactory.hpp"
 #include "factories/NPNFactory.hpp"
 #include "factories/NonComponentFactory.hpp"
+#include "factories/PotentiometerFactory.hpp"
 #include "factories/ResistorFactory.hpp"
 #include "factories/VoltageSourceFactory.hpp"
 #include <SDL_image.h>
@@ -41,6 +42,7 @@ void registerComponents() {
   reg.registerFactory("npn", new NPNFactory());
   reg.registerFactory("diode", new DiodeFactory());
   reg.registerFactory("res", new ResistorFactory());
+  reg.registerFactory("pot", new PotentiometerFactory());
   reg.registerFactory("cap", new CapacitorFactory());
   reg.registerFactory("src", new VoltageSourceFactory());
   path prefix = std::filesystem::current_path().parent_path() / "assets/icons";
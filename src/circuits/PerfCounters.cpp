@@ -0,0 +1,180 @@
+#include "PerfCounters.hpp"
+#include <cerrno>
+#include <cstring>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+static const uint64_t eventConfigs[] = {
+    PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+
+static int currentThread() {
+  thread_local int tid = 0;
+  if (tid == 0) {
+    tid = syscall(SYS_gettid);
+  }
+  return tid;
+}
+
+bool PerfCounters::open() {
+  for (int p = 0; p < NUM_PERF_PHASES; ++p) {
+    for (int e = 0; e < NUM_EVENTS; ++e) {
+      perf_event_attr attr;
+      memset(&attr, 0, sizeof(attr));
+      attr.size = sizeof(attr);
+      attr.type = PERF_TYPE_HARDWARE;
+      attr.config = eventConfigs[e];
+      attr.disabled = e == CYCLES; // The others follow their group leader
+      attr.exclude_kernel = 1;     // Also keeps the ioctls out of the counts
+      attr.exclude_hv = 1;
+      attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED |
+                         PERF_FORMAT_TOTAL_TIME_RUNNING;
+      int leader = e == CYCLES ? -1 : fds[p][CYCLES];
+      fds[p][e] = syscall(SYS_perf_event_open, &attr, 0, -1, leader, 0);
+      if (fds[p][e] < 0) {
+        error = errno;
+        close();
+        return false;
+      }
+    }
+  }
+  error = 0;
+  return true;
+}
+
+void PerfCounters::close() {
+  for (auto &phase : fds) {
+    for (int &fd : phase) {
+      if (fd >= 0) {
+        ::close(fd);
+      }
+      fd = -1;
+    }
+  }
+}
+
+void PerfCounters::begin(PerfPhase phase) {
+  int tid = currentThread();
+  if (tid != thread) {
+    // Counters only follow the thread that opened them
+    if (thread != 0) {
+      publish();
+      for (int p = 0; p < NUM_PERF_PHASES; ++p) {
+        for (int e = 0; e < NUM_EVENTS; ++e) {
+          base[p][e] = totals[p][e];
+        }
+      }
+      close();
+    }
+    thread = tid;
+    open();
+  }
+  if (fds[phase][CYCLES] >= 0) {
+    ioctl(fds[phase][CYCLES], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+  }
+}
+
+void PerfCounters::end(PerfPhase phase) {
+  if (fds[phase][CYCLES] < 0) {
+    return;
+  }
+  ioctl(fds[phase][CYCLES], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+  uint64_t count = calls[phase].load(std::memory_order_relaxed) + 1;
+  calls[phase].store(count, std::memory_order_relaxed);
+  if (count % PUBLISH_INTERVAL == 0) {
+    publish(phase);
+  }
+}
+
+void PerfCounters::publish(PerfPhase phase) {
+  if (fds[phase][CYCLES] < 0) {
+    return;
+  }
+  struct {
+    uint64_t count;
+    uint64_t timeEnabled;
+    uint64_t timeRunning;
+    uint64_t values[NUM_EVENTS];
+  } group;
+  if (::read(fds[phase][CYCLES], &group, sizeof(group)) != sizeof(group)) {
+    return;
+  }
+  // Scale up when the kernel had to share the hardware counters
+  double scale = 1.0;
+  if (group.timeRunning > 0 && group.timeRunning < group.timeEnabled) {
+    scale = (double)group.timeEnabled / group.timeRunning;
+  }
+  for (int e = 0; e < NUM_EVENTS; ++e) {
+    totals[phase][e].store(base[phase][e] + group.values[e] * scale,
+                           std::memory_order_relaxed);
+  }
+}
+
+#else
+
+bool PerfCounters::open() {
+  error = ENOSYS;
+  return false;
+}
+void PerfCounters::close() {}
+void PerfCounters::begin(PerfPhase phase) {
+  if (thread == 0) {
+    thread = 1;
+    open();
+  }
+}
+void PerfCounters::end(PerfPhase phase) {}
+void PerfCounters::publish(PerfPhase phase) {}
+
+#endif
+
+PerfCounters::PerfCounters() {
+  for (auto &phase : fds) {
+    for (int &fd : phase) {
+      fd = -1;
+    }
+  }
+}
+
+PerfCounters::~PerfCounters() { close(); }
+
+void PerfCounters::publish() {
+  for (int p = 0; p < NUM_PERF_PHASES; ++p) {
+    publish((PerfPhase)p);
+  }
+}
+
+PerfCounts PerfCounters::read(PerfPhase phase) const {
+  PerfCounts counts;
+  counts.calls = calls[phase].load(std::memory_order_relaxed);
+  counts.cycles = totals[phase][CYCLES].load(std::memory_order_relaxed);
+  counts.instructions =
+      totals[phase][INSTRUCTIONS].load(std::memory_order_relaxed);
+  counts.cacheMisses =
+      totals[phase][CACHE_MISSES].load(std::memory_order_relaxed);
+  counts.branchMisses =
+      totals[phase][BRANCH_MISSES].load(std::memory_order_relaxed);
+  return counts;
+}
+
+std::string PerfCounters::getError() const {
+  int e = error.load();
+  return e == 0 ? std::string() : std::string(strerror(e));
+}
+
+const char *PerfCounters::phaseName(PerfPhase phase) {
+  switch (phase) {
+  case PERF_STAMP:
+    return "stamp";
+  case PERF_FACTORIZE:
+    return "factorize";
+  case PERF_UPDATE_STATE:
+    return "updateState";
+  default:
+    return "unknown";
+  }
+}
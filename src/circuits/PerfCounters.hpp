@@ -0,0 +1,78 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+enum PerfPhase {
+  PERF_STAMP,
+  PERF_FACTORIZE,
+  PERF_UPDATE_STATE,
+  NUM_PERF_PHASES,
+};
+
+struct PerfCounts {
+  uint64_t calls = 0;
+  uint64_t cycles = 0;
+  uint64_t instructions = 0;
+  uint64_t cacheMisses = 0;
+  uint64_t branchMisses = 0;
+};
+
+// Hardware counters around the solver phases, through Linux perf_event_open.
+// Each phase has its own counter group that only runs between begin and end,
+// in user space, on the thread that solves. That thread opens the groups on
+// its first begin and reads them back every few hundred calls, so this costs
+// syscalls on the audio thread: it is an instrumentation mode, not something
+// to leave on.
+class PerfCounters {
+  enum { CYCLES, INSTRUCTIONS, CACHE_MISSES, BRANCH_MISSES, NUM_EVENTS };
+  static const uint64_t PUBLISH_INTERVAL = 256; // Calls between two reads
+
+  // Solving thread only
+  int fds[NUM_PERF_PHASES][NUM_EVENTS];
+  uint64_t base[NUM_PERF_PHASES][NUM_EVENTS] = {}; // Counted by older threads
+  int thread = 0;
+
+  // Shared with the readers
+  std::atomic<uint64_t> calls[NUM_PERF_PHASES] = {};
+  std::atomic<uint64_t> totals[NUM_PERF_PHASES][NUM_EVENTS] = {};
+  std::atomic<int> error{0}; // errno of the failed perf_event_open
+
+  bool open();
+  void close();
+  void publish(PerfPhase phase);
+
+public:
+  PerfCounters();
+  ~PerfCounters();
+  // No-ops when the counters could not be opened
+  void begin(PerfPhase phase);
+  void end(PerfPhase phase);
+  // Makes the latest counts visible to read. Solving thread only, read
+  // catches up by itself every PUBLISH_INTERVAL calls.
+  void publish();
+  // Totals from every thread that solved so far. Any thread may call this.
+  PerfCounts read(PerfPhase phase) const;
+  // Why the counters are unavailable, empty when they work
+  std::string getError() const;
+  static const char *phaseName(PerfPhase phase);
+
+  class Scope {
+    PerfCounters *counters;
+    PerfPhase phase;
+
+  public:
+    Scope(PerfCounters *counters, PerfPhase phase)
+        : counters(counters), phase(phase) {
+      if (counters) {
+        counters->begin(phase);
+      }
+    }
+    ~Scope() {
+      if (counters) {
+        counters->end(phase);
+      }
+    }
+  };
+};
@@ -0,0 +1,86 @@
+#include "SolverStats.hpp"
+#include <algorithm>
+
+double SolverSnapshot::meanIterations() const {
+  if (samples == 0) {
+    return 0.0;
+  }
+  uint64_t total = 0;
+  for (int i = 0; i < NUM_BINS; ++i) {
+    total += i * iterations[i];
+  }
+  return (double)total / samples;
+}
+
+template <typename T> static void raise(std::atomic<T> &max, T value) {
+  T previous = max.load(std::memory_order_relaxed);
+  while (value > previous &&
+         !max.compare_exchange_weak(previous, value,
+                                    std::memory_order_relaxed)) {
+  }
+}
+
+// Single writer: the counters only need their own loads and stores, the
+// maxima are also cleared by the reader
+template <typename T> static void increment(std::atomic<T> &x, T by = 1) {
+  x.store(x.load(std::memory_order_relaxed) + by, std::memory_order_relaxed);
+}
+
+void SolverStats::recordSample(int count, bool converged, double residual,
+                               Clock::duration elapsed, bool fullEffort) {
+  increment(iterations[std::min(count, SolverSnapshot::NUM_BINS - 1)]);
+  if (fullEffort) {
+    if (!converged) {
+      increment(nonConverged);
+    }
+    raise(maxResidual, residual);
+  }
+  raise(worstSampleNs,
+        std::chrono::duration<double, std::nano>(elapsed).count());
+}
+
+void SolverStats::recordBuffer(uint64_t count, uint64_t degraded) {
+  increment(factorizations, count);
+  raise(maxFactorizations, count);
+  if (degraded) {
+    increment(degradedBuffers);
+    increment(degradedSamples, degraded);
+  }
+  buffers.fetch_add(1, std::memory_order_release);
+}
+
+const SolverSnapshot &SolverStats::read(double interval) {
+  Clock::time_point now = Clock::now();
+  if (std::chrono::duration<double>(now - lastRefresh).count() < interval) {
+    return snapshot;
+  }
+  lastRefresh = now;
+
+  SolverSnapshot current;
+  current.buffers = buffers.load(std::memory_order_acquire);
+  for (int i = 0; i < SolverSnapshot::NUM_BINS; ++i) {
+    current.iterations[i] = iterations[i].load(std::memory_order_relaxed);
+    current.samples += current.iterations[i];
+  }
+  current.nonConverged = nonConverged.load(std::memory_order_relaxed);
+  current.factorizations = factorizations.load(std::memory_order_relaxed);
+  current.degradedBuffers = degradedBuffers.load(std::memory_order_relaxed);
+  current.degradedSamples = degradedSamples.load(std::memory_order_relaxed);
+
+  for (int i = 0; i < SolverSnapshot::NUM_BINS; ++i) {
+    snapshot.iterations[i] = current.iterations[i] - seen.iterations[i];
+  }
+  snapshot.samples = current.samples - seen.samples;
+  snapshot.nonConverged = current.nonConverged - seen.nonConverged;
+  snapshot.buffers = current.buffers - seen.buffers;
+  snapshot.factorizations = current.factorizations - seen.factorizations;
+  snapshot.degradedBuffers = current.degradedBuffers - seen.degradedBuffers;
+  snapshot.degradedSamples = current.degradedSamples - seen.degradedSamples;
+  snapshot.maxFactorizationsPerBuffer =
+      maxFactorizations.exchange(0, std::memory_order_relaxed);
+  snapshot.maxResidual = maxResidual.exchange(0.0, std::memory_order_relaxed);
+  snapshot.worstSampleNs =
+      worstSampleNs.exchange(0.0, std::memory_order_relaxed);
+  seen = current;
+  return snapshot;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+struct SolverSnapshot {
+  // One bin per iteration count up to Circuit::MAX_ITERATIONS, which
+  // Circuit.hpp checks
+  static const int NUM_BINS = 21;
+  // Samples by Newton iterations spent, the last bin holds NUM_BINS - 1 or
+  // more
+  uint64_t iterations[NUM_BINS] = {};
+  uint64_t samples = 0;
+  // Samples that hit the full iteration limit. Degraded ones stop on a
+  // lower limit on purpose and are only counted in degradedSamples.
+  uint64_t nonConverged = 0;
+  uint64_t buffers = 0;
+  uint64_t factorizations = 0;
+  uint64_t maxFactorizationsPerBuffer = 0;
+  uint64_t degradedBuffers = 0; // Cut short to meet their deadline
+  uint64_t degradedSamples = 0;
+  // Largest relative Newton update left at the end of a full-effort sample
+  double maxResidual = 0.0;
+  double worstSampleNs = 0.0; // Longest time spent on one sample
+
+  double meanIterations() const;
+};
+
+// Convergence statistics of one circuit's transient solver. The solver
+// thread records, one other thread reads; neither waits for the other.
+class SolverStats {
+  std::atomic<uint64_t> iterations[SolverSnapshot::NUM_BINS] = {};
+  std::atomic<uint64_t> nonConverged{0};
+  std::atomic<uint64_t> buffers{0};
+  std::atomic<uint64_t> factorizations{0};
+  std::atomic<uint64_t> maxFactorizations{0};
+  std::atomic<uint64_t> degradedBuffers{0};
+  std::atomic<uint64_t> degradedSamples{0};
+  std::atomic<double> maxResidual{0.0};
+  std::atomic<double> worstSampleNs{0.0};
+
+  // Reader side
+  SolverSnapshot seen;
+  SolverSnapshot snapshot;
+  std::chrono::steady_clock::time_point lastRefresh;
+
+public:
+  using Clock = std::chrono::steady_clock;
+
+  // fullEffort: the sample had the full iteration limit, not a degraded one
+  void recordSample(int iterations, bool converged, double residual,
+                    Clock::duration elapsed, bool fullEffort = true);
+  // degradedSamples were solved with less effort to meet a deadline
+  void recordBuffer(uint64_t factorizations, uint64_t degradedSamples = 0);
+  // Everything recorded between the two last refreshes, so the first call
+  // covers everything since construction. Calls less than `interval`
+  // seconds after a refresh return the same snapshot.
+  const SolverSnapshot &read(double interval = 0.0);
+};
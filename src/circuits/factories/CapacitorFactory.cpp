@@ -41,7 +41,7 @@ const vector<pair<int, int>> &CapacitorFactory::getPins() const {
 }
 
 CapacitorFactory::CapacitorFactory() {
-  if (texture == nullptr) {
+  if (texture == nullptr && Application::getInstance()) {
     SDL_Renderer *renderer = Application::getInstance()->getRenderer();
     path texturePath = std::filesystem::current_path().parent_path() /
                        "assets/icons/capacitor.png";
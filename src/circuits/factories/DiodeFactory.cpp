@@ -45,7 +45,7 @@ const vector<pair<int, int>> &DiodeFactory::getPins() const {
 void *DiodeFactory::texture = nullptr;
 
 DiodeFactory::DiodeFactory() {
-  if (texture == nullptr) {
+  if (texture == nullptr && Application::getInstance()) {
     SDL_Renderer *renderer = Application::getInstance()->getRenderer();
     path texturePath = std::filesystem::current_path().parent_path() /
                        "assets/icons/diode.png";
@@ -43,7 +43,7 @@ const vector<pair<int, int>> &NPNFactory::getPins() const {
 }
 
 NPNFactory::NPNFactory() {
-  if (texture == nullptr) {
+  if (texture == nullptr && Application::getInstance()) {
     SDL_Renderer *renderer = Application::getInstance()->getRenderer();
     path texturePath =
         std::filesystem::current_path().parent_path() / "assets/icons/npn.png";
@@ -7,7 +7,8 @@ std::unordered_map<path, void *> NonComponentFactory::textureMap;
 NonComponentFactory::NonComponentFactory(path texturePath,
                                          vector<pair<int, int>> pins)
     : texturePath(texturePath), pins(pins) {
-  if (textureMap.find(texturePath) == textureMap.end()) {
+  if (textureMap.find(texturePath) == textureMap.end() &&
+      Application::getInstance()) {
     SDL_Renderer *renderer = Application::getInstance()->getRenderer();
     void *texture = IMG_LoadTexture(renderer, texturePath.c_str());
     textureMap.emplace(texturePath, texture);
@@ -0,0 +1,64 @@
+#include "PotentiometerFactory.hpp"
+#include "../../core/Application.hpp"
+#include "../models/PotentiometerModel.hpp"
+#include <SDL_image.h>
+#include <filesystem>
+#include <stdexcept>
+
+using std::filesystem::path;
+
+ComponentModel *PotentiometerFactory::fromJson(const json &data,
+                                               const int *const pins,
+                                               const size_t &nPins) {
+  if (nPins != 3) {
+    throw std::runtime_error("Expected exactly 3 pins in potentiometer. Got " +
+                             std::to_string(nPins));
+  }
+  if (!data.contains("r")) {
+    throw std::runtime_error("Malformed json: Expected \'r\' field.");
+  }
+  if (!data.contains("position")) {
+    throw std::runtime_error("Malformed json: Expected \'position\' field.");
+  }
+  float r = data["r"]["value"].get<float>();
+  float position = data["position"]["value"].get<float>();
+  return new PotentiometerModel(r, position, pins[0], pins[1], pins[2]);
+}
+
+string PotentiometerFactory::getComponentType() const { return "pot"; }
+
+json PotentiometerFactory::getDefaultJson() const {
+  return {{"r",
+           {
+               {"max", 1e7},
+               {"min", 100},
+               {"value", 1e5},
+           }},
+          {"position",
+           {
+               {"max", 1},
+               {"min", 0},
+               {"value", 0.5},
+           }}};
+}
+
+void *PotentiometerFactory::getTexture() const { return texture; }
+
+pair<int, int> PotentiometerFactory::getSize() const { return {2, 2}; }
+
+// Ends on the sides, wiper on top
+const vector<pair<int, int>> &PotentiometerFactory::getPins() const {
+  static const vector<pair<int, int>> pins = {{-1, 0}, {0, -1}, {1, 0}};
+  return pins;
+}
+
+PotentiometerFactory::PotentiometerFactory() {
+  if (texture == nullptr && Application::getInstance()) {
+    SDL_Renderer *renderer = Application::getInstance()->getRenderer();
+    path texturePath = std::filesystem::current_path().parent_path() /
+                       "assets/icons/potentiometer.png";
+    texture = IMG_LoadTexture(renderer, texturePath.c_str());
+  }
+}
+
+void *PotentiometerFactory::texture = nullptr;
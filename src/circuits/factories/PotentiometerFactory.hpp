@@ -0,0 +1,19 @@
+#pragma once
+
+#include "ComponentFactory.hpp"
+
+class PotentiometerFactory : public ComponentFactory {
+protected:
+  static void *texture;
+
+public:
+  ~PotentiometerFactory() = default;
+  PotentiometerFactory();
+  ComponentModel *fromJson(const json &data, const int *const pins,
+                           const size_t &nPins) override;
+  string getComponentType() const override;
+  json getDefaultJson() const override;
+  void *getTexture() const override;
+  pair<int, int> getSize() const override;
+  const vector<pair<int, int>> &getPins() const override;
+};
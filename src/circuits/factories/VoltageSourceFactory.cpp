@@ -41,7 +41,7 @@ const vector<pair<int, int>> &VoltageSourceFactory::getPins() const {
 }
 
 VoltageSourceFactory::VoltageSourceFactory() {
-  if (texture == nullptr) {
+  if (texture == nullptr && Application::getInstance()) {
     SDL_Renderer *renderer = Application::getInstance()->getRenderer();
     path texturePath = std::filesystem::current_path().parent_path() /
                        "assets/icons/voltagesource.png";
@@ -4,10 +4,18 @@
 #include <SDL2/SDL_image.h>
 
 CapacitorModel::CapacitorModel(double C, int n1, int n2)
-    : C(C), node1(n1), node2(n2) {}
+    : C(C), node1(n1), node2(n2) {
+  initializeState();
+}
 
 void CapacitorModel::stamp(Eigen::MatrixXd &G, Eigen::VectorXd &I,
                            double currentTime, double dt) {
+  // The companion model integrates from the previous time step, not from the
+  // previous Newton iteration: only roll the history over on a new time.
+  if (currentTime != stampTime) {
+    prevVoltage = voltage;
+    stampTime = currentTime;
+  }
   double Geq = C / dt;
   double Ieq = Geq * prevVoltage;
 
@@ -29,7 +37,23 @@ void CapacitorModel::updateState(const Eigen::VectorXd &V,
                                  const Eigen::VectorXd &I) {
   double vNode1 = Circuit::isNodeGround(node1) ? 0.0 : V(node1);
   double vNode2 = Circuit::isNodeGround(node2) ? 0.0 : V(node2);
-  prevVoltage = vNode2 - vNode1;
+  voltage = vNode2 - vNode1;
 }
 
-void CapacitorModel::initializeState() { prevVoltage = 0.0; }
+void CapacitorModel::initializeState() {
+  prevVoltage = 0.0;
+  voltage = 0.0;
+  stampTime = 0.0;
+}
+
+vector<int> CapacitorModel::getUnknowns() const {
+  return pinUnknowns({node1, node2});
+}
+
+int CapacitorModel::getParameterIndex(const std::string &name) const {
+  return name == "c" ? 0 : -1;
+}
+
+double CapacitorModel::getParameter(int index) const { return C; }
+
+void CapacitorModel::setParameter(int index, double value) { C = value; }
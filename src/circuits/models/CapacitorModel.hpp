@@ -2,9 +2,11 @@
 
 #include "ComponentModel.hpp"
 
-class CapacitorModel : public ComponentModel {
+class CapacitorModel : public CloneableModel<CapacitorModel> {
   double C;
-  double prevVoltage;
+  double prevVoltage; // Voltage at the end of the previous time step
+  double voltage;     // Voltage of the latest Newton iterate
+  double stampTime;
   int node1, node2;
 
 public:
@@ -13,4 +15,8 @@ public:
              double dt) override;
   void updateState(const Eigen::VectorXd &V, const Eigen::VectorXd &I) override;
   void initializeState() override;
+  vector<int> getUnknowns() const override;
+  int getParameterIndex(const std::string &name) const override;
+  double getParameter(int index) const override;
+  void setParameter(int index, double value) override;
 };
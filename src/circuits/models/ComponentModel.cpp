@@ -1,4 +1,5 @@
 #include "ComponentModel.hpp"
+#include "../Circuit.hpp"
 
 void ComponentModel::updateState(const Eigen::VectorXd &V,
                             const Eigen::VectorXd &I) {
@@ -8,3 +9,27 @@ void ComponentModel::updateState(const Eigen::VectorXd &V,
 void ComponentModel::initializeState() {
   // Do nothing for non transient basic components...
 }
+
+int ComponentModel::getParameterIndex(const std::string &name) const {
+  return -1;
+}
+
+double ComponentModel::getParameter(int index) const { return 0.0; }
+
+void ComponentModel::setParameter(int index, double value) {}
+
+bool ComponentModel::isParameterLogarithmic(int index) const { return true; }
+
+int ComponentModel::getNumConductances() const { return 0; }
+
+void ComponentModel::getConductances(Conductance *out) const {}
+
+vector<int> ComponentModel::pinUnknowns(std::initializer_list<int> pins) {
+  vector<int> res;
+  for (int n : pins) {
+    if (!Circuit::isNodeGround(n)) {
+      res.emplace_back(n);
+    }
+  }
+  return res;
+}
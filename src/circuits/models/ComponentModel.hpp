@@ -2,17 +2,61 @@
 #include "nlohmann/json_fwd.hpp"
 #include <SDL_render.h>
 #include <eigen3/Eigen/Dense>
+#include <initializer_list>
 #include <nlohmann/json.hpp>
+#include <string>
 #include <vector>
 
 using json = nlohmann::json;
 
 using std::vector;
 
+// A conductance between two unknowns, -1 for ground
+struct Conductance {
+  int node1, node2;
+  double g;
+};
+
 class ComponentModel {
 public:
+  virtual ~ComponentModel() = default;
   virtual void stamp(Eigen::MatrixXd &matrix, Eigen::VectorXd &rhs,
                      double currentTime, double dt) = 0;
   virtual void updateState(const Eigen::VectorXd &V, const Eigen::VectorXd &I);
   virtual void initializeState();
+  // Indices of the MNA unknowns (node voltages and branch currents) this
+  // component stamps into, ground excluded.
+  virtual vector<int> getUnknowns() const = 0;
+  virtual ComponentModel *clone() const = 0;
+  // Takes over the state of a model of the same type, in place, e.g. to
+  // rewind to a copy made with clone()
+  virtual void copyState(const ComponentModel &from) = 0;
+  // Values that may change while the circuit runs, named after the keys of
+  // the component's JSON data. -1 when there is no such parameter.
+  virtual int getParameterIndex(const std::string &name) const;
+  virtual double getParameter(int index) const;
+  virtual void setParameter(int index, double value);
+  // Ramped geometrically when true, linearly otherwise
+  virtual bool isParameterLogarithmic(int index) const;
+  // Conductances that change often, such as a potentiometer's, that the
+  // solver may apply as a low-rank update to the factorization of the rest
+  // of the circuit instead of stamping them. Only for components whose whole
+  // stamp is these conductances, between fixed nodes.
+  virtual int getNumConductances() const;
+  virtual void getConductances(Conductance *out) const;
+
+protected:
+  // getUnknowns for a component that stamps only into its pins' nodes
+  static vector<int> pinUnknowns(std::initializer_list<int> pins);
+};
+
+// clone and copyState for a model T that copies as a plain value:
+// class T : public CloneableModel<T>
+template <class T> struct CloneableModel : ComponentModel {
+  ComponentModel *clone() const override {
+    return new T(static_cast<const T &>(*this));
+  }
+  void copyState(const ComponentModel &from) override {
+    static_cast<T &>(*this) = static_cast<const T &>(from);
+  }
 };
@@ -82,6 +82,7 @@ void DiodeModel::initializeState() {
   currentVoltage = 0.0;
   currentCurrent = 0.0;
   conductance = 1e-9; // Tiny conductance to avoid division by zero
+  equivalentCurrent = 0.0;
 }
 
 void DiodeModel::stampCurrent(Eigen::MatrixXd &G, Eigen::VectorXd &I) {
@@ -136,3 +137,7 @@ void DiodeModel::updateState(const Eigen::VectorXd &V,
 const vector<string> &DiodeModel::getModels() { return models; }
 
 vector<string> DiodeModel::models;
+
+vector<int> DiodeModel::getUnknowns() const {
+  return pinUnknowns({anode, cathode});
+}
@@ -15,7 +15,7 @@ struct DiodeModelParameters {
   double Tt;  // Transit time
 };
 
-class DiodeModel : public ComponentModel {
+class DiodeModel : public CloneableModel<DiodeModel> {
 protected:
   static vector<string> models;
 
@@ -46,5 +46,6 @@ public:
              double dt) override;
   void updateState(const Eigen::VectorXd &V, const Eigen::VectorXd &I) override;
   void initializeState() override;
+  vector<int> getUnknowns() const override;
   static const vector<string> &getModels();
 };
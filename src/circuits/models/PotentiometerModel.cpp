@@ -0,0 +1,73 @@
+#include "PotentiometerModel.hpp"
+#include "../Circuit.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+PotentiometerModel::PotentiometerModel(double r, double position, int end1,
+                                       int wiper, int end2)
+    : resistance(r), position(position), end1(end1), wiper(wiper),
+      end2(end2) {
+  if (r <= 0) {
+    throw std::runtime_error("Can't have potentiometer with resistance <= 0.");
+  }
+  if (position < 0 || position > 1) {
+    throw std::runtime_error("Potentiometer position must be within [0, 1].");
+  }
+}
+
+void PotentiometerModel::stamp(Eigen::MatrixXd &matrix, Eigen::VectorXd &rhs,
+                               double currentTime, double dt) {
+  Conductance halves[2];
+  getConductances(halves);
+  for (const auto &c : halves) {
+    if (!Circuit::isNodeGround(c.node1)) {
+      matrix(c.node1, c.node1) += c.g;
+      if (!Circuit::isNodeGround(c.node2)) {
+        matrix(c.node1, c.node2) -= c.g;
+        matrix(c.node2, c.node1) -= c.g;
+      }
+    }
+    if (!Circuit::isNodeGround(c.node2)) {
+      matrix(c.node2, c.node2) += c.g;
+    }
+  }
+}
+
+vector<int> PotentiometerModel::getUnknowns() const {
+  return pinUnknowns({end1, wiper, end2});
+}
+
+int PotentiometerModel::getParameterIndex(const std::string &name) const {
+  if (name == "r") {
+    return RESISTANCE;
+  }
+  if (name == "position") {
+    return POSITION;
+  }
+  return -1;
+}
+
+double PotentiometerModel::getParameter(int index) const {
+  return index == POSITION ? position : resistance;
+}
+
+void PotentiometerModel::setParameter(int index, double value) {
+  if (index == POSITION) {
+    position = std::clamp(value, 0.0, 1.0);
+  } else {
+    resistance = value;
+  }
+}
+
+bool PotentiometerModel::isParameterLogarithmic(int index) const {
+  return index != POSITION;
+}
+
+int PotentiometerModel::getNumConductances() const { return 2; }
+
+void PotentiometerModel::getConductances(Conductance *out) const {
+  double r1 = std::max(MIN_RESISTANCE, resistance * position);
+  double r2 = std::max(MIN_RESISTANCE, resistance * (1.0 - position));
+  out[0] = {end1, wiper, 1.0 / r1};
+  out[1] = {wiper, end2, 1.0 / r2};
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "ComponentModel.hpp"
+
+// A track of resistance between two ends with a wiper on it. At position 0
+// the wiper sits on the first end, at 1 on the second one.
+class PotentiometerModel : public CloneableModel<PotentiometerModel> {
+  static constexpr double MIN_RESISTANCE = 1.0; // Wiper at the very end
+  double resistance;
+  double position;
+  int end1, wiper, end2;
+
+public:
+  enum { RESISTANCE, POSITION };
+  PotentiometerModel(double r, double position, int end1, int wiper,
+                     int end2);
+  void stamp(Eigen::MatrixXd &matrix, Eigen::VectorXd &rhs, double currentTime,
+             double dt) override;
+  vector<int> getUnknowns() const override;
+  int getParameterIndex(const std::string &name) const override;
+  double getParameter(int index) const override;
+  void setParameter(int index, double value) override;
+  bool isParameterLogarithmic(int index) const override;
+  int getNumConductances() const override;
+  void getConductances(Conductance *out) const override;
+};
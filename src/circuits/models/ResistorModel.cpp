@@ -27,3 +27,17 @@ void ResistorModel::stamp(Eigen::MatrixXd &matrix, Eigen::VectorXd &rhs,
     matrix(node2, node2) += G_;
   }
 }
+
+vector<int> ResistorModel::getUnknowns() const {
+  return pinUnknowns({node1, node2});
+}
+
+int ResistorModel::getParameterIndex(const std::string &name) const {
+  return name == "r" ? 0 : -1;
+}
+
+double ResistorModel::getParameter(int index) const { return resistance; }
+
+void ResistorModel::setParameter(int index, double value) {
+  resistance = value;
+}
@@ -2,11 +2,15 @@
 
 #include "ComponentModel.hpp"
 
-class ResistorModel : public ComponentModel {
+class ResistorModel : public CloneableModel<ResistorModel> {
   double resistance;
   int node1, node2;
 
 public:
   ResistorModel(double r, int n1, int n2);
   void stamp(Eigen::MatrixXd &matrix, Eigen::VectorXd &rhs, double currentTime, double dt) override;
+  vector<int> getUnknowns() const override;
+  int getParameterIndex(const std::string &name) const override;
+  double getParameter(int index) const override;
+  void setParameter(int index, double value) override;
 };
@@ -31,3 +31,27 @@ void VoltageSourceModel::stamp(Eigen::MatrixXd &matrix, Eigen::VectorXd &rhs,
 }
 
 void VoltageSourceModel::setVoltage(double v) { voltage = v; }
+
+vector<int> VoltageSourceModel::getUnknowns() const {
+  vector<int> res = pinUnknowns({posNode, negNode});
+  // The branch current only gets an index once the source has been stamped
+  if (called) {
+    res.emplace_back(index);
+  }
+  return res;
+}
+
+int VoltageSourceModel::getParameterIndex(const std::string &name) const {
+  return name == "v" ? 0 : -1;
+}
+
+double VoltageSourceModel::getParameter(int index) const { return voltage; }
+
+void VoltageSourceModel::setParameter(int index, double value) {
+  voltage = value;
+}
+
+// Voltages may be zero or negative
+bool VoltageSourceModel::isParameterLogarithmic(int index) const {
+  return false;
+}
@@ -2,7 +2,7 @@
 
 #include "ComponentModel.hpp"
 
-class VoltageSourceModel : public ComponentModel {
+class VoltageSourceModel : public CloneableModel<VoltageSourceModel> {
 protected:
   double voltage;
   int posNode, negNode;
@@ -12,4 +12,9 @@ public:
   VoltageSourceModel(double v, int p, int n);
   void setVoltage(double v);
   void stamp(Eigen::MatrixXd &matrix, Eigen::VectorXd &rhs, double currentTime, double dt) override;
+  vector<int> getUnknowns() const override;
+  int getParameterIndex(const std::string &name) const override;
+  double getParameter(int index) const override;
+  void setParameter(int index, double value) override;
+  bool isParameterLogarithmic(int index) const override;
 };
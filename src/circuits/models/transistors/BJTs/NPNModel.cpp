@@ -2,6 +2,7 @@
 #include "../../../Circuit.hpp"
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_image.h>
+#include <cmath>
 #include <stdexcept>
 
 std::unordered_map<std::string, NPNModelParameters> NPNModel::modelLibrary = {
@@ -101,6 +102,19 @@ void NPNModel::initializeState() {
   dIc_dVbc = 1e-9;
   dIb_dVbe = 1e-9;
   dIb_dVbc = 1e-9;
+
+  // Linearization at zero bias, as updateState would compute it, so that the
+  // first stamp doesn't read uninitialized values
+  Vce = 0.0;
+  VbeLimited = 0.0;
+  VbcLimited = 0.0;
+  g_0 = params.Is / Vt;
+  g_m = 2.0 * params.Is / Vt;
+  g_pi = params.Is / (Vt * params.Bf);
+  g_mu = params.Is / (Vt * params.Br);
+  IBE_eq = 0.0;
+  IBC_eq = 0.0;
+  ICE_eq = 2.0 * params.Is;
 }
 
 void NPNModel::stampBaseCurrent(Eigen::MatrixXd &G, Eigen::VectorXd &I) {
@@ -149,6 +163,22 @@ void NPNModel::stamp(Eigen::MatrixXd &G, Eigen::VectorXd &I, double t,
   stampEmitterCurrent(G, I);
 }
 
+// SPICE's pnjlim: above the critical voltage, a junction may only move by
+// about the log of the step, so that one Newton step can't make exp() blow
+// up the conductances.
+static double limitJunction(double v, double previous, double Vt,
+                            double Is) {
+  double critical = Vt * std::log(Vt / (std::sqrt(2.0) * Is));
+  if (v <= critical || std::abs(v - previous) <= 2.0 * Vt) {
+    return v;
+  }
+  if (previous > 0.0) {
+    double arg = 1.0 + (v - previous) / Vt;
+    return arg > 0.0 ? previous + Vt * std::log(arg) : critical;
+  }
+  return Vt * std::log(v / Vt);
+}
+
 void NPNModel::updateState(const Eigen::VectorXd &V, const Eigen::VectorXd &I) {
   // Get node voltages
   double Vb = Circuit::isNodeGround(b) ? 0.0 : V(b);
@@ -166,9 +196,14 @@ void NPNModel::updateState(const Eigen::VectorXd &V, const Eigen::VectorXd &I) {
   const double MAX_VBC =
       5.0 * 0.8; // Reasonable maximum for base-collector voltage
 
+  VbeLimited = limitJunction(Vbe, VbeLimited, Vt, params.Is);
+  VbcLimited = limitJunction(Vbc, VbcLimited, Vt, params.Is);
+
   // Apply clamping to prevent exponential overflow
-  double Vbe_clamped = std::min(std::max(Vbe, -5.0 * 80.0 * Vt), MAX_VBE);
-  double Vbc_clamped = std::min(std::max(Vbc, -5.0 * 80.0 * Vt), MAX_VBC);
+  double Vbe_clamped =
+      std::min(std::max(VbeLimited, -5.0 * 80.0 * Vt), MAX_VBE);
+  double Vbc_clamped =
+      std::min(std::max(VbcLimited, -5.0 * 80.0 * Vt), MAX_VBC);
 
   // Constants for model calculations
   double Ise = 0.0; // Default value for the moment
@@ -226,3 +261,7 @@ void NPNModel::updateState(const Eigen::VectorXd &V, const Eigen::VectorXd &I) {
 vector<string> NPNModel::models;
 
 const vector<string> &NPNModel::getModels() { return models; }
+
+vector<int> NPNModel::getUnknowns() const {
+  return pinUnknowns({b, c, e});
+}
@@ -21,7 +21,7 @@ struct NPNModelParameters {
   double Vtf;  // Transit time dependance on Vbc
 };
 
-class NPNModel : public ComponentModel {
+class NPNModel : public CloneableModel<NPNModel> {
 private:
   static vector<string> models;
 
@@ -39,6 +39,8 @@ private:
   double Vbe; // Base-emitter voltage
   double Vce; // Collector-emitter voltage
   double Vbc; // Base-collector voltage
+  // Junction voltages the last linearization used, after step limiting
+  double VbeLimited, VbcLimited;
 
   double IBE_eq, IBC_eq, ICE_eq;
   double g_0, g_mu, g_pi, g_m;
@@ -72,5 +74,6 @@ public:
   void updateState(const Eigen::VectorXd &V, const Eigen::VectorXd &I) override;
 
   void initializeState() override;
+  vector<int> getUnknowns() const override;
   static const vector<string> &getModels();
 };
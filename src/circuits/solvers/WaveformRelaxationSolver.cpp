@@ -0,0 +1,277 @@
+#include "WaveformRelaxationSolver.hpp"
+#include "../../audio/engine/WorkerPool.hpp"
+#include <algorithm>
+#include <cmath>
+#include <queue>
+#include <set>
+#include <stdexcept>
+
+WaveformRelaxationSolver::WaveformRelaxationSolver(
+    Circuit *c, const WaveformRelaxationOptions &opts)
+    : circuit(c), options(opts) {
+  if (options.windowSize == 0) {
+    options.windowSize = 1;
+  }
+}
+
+WaveformRelaxationSolver::~WaveformRelaxationSolver() { clearPartitions(); }
+
+void WaveformRelaxationSolver::clearPartitions() {
+  for (auto &p : partitions) {
+    for (auto comp : p.newton.models) {
+      delete comp;
+    }
+    for (auto comp : p.checkpoint) {
+      delete comp;
+    }
+  }
+  partitions.clear();
+}
+
+void WaveformRelaxationSolver::buildPartitions(int input) {
+  clearPartitions();
+  inputNode = input;
+  numUnknowns = circuit->getLastIndex();
+  int numNodes = circuit->getNumStates();
+  const vector<ComponentModel *> &comps = circuit->getComponents();
+  int count = std::max(1, std::min(options.partitions, numNodes));
+
+  vector<vector<int>> unknowns(comps.size());
+  vector<vector<int>> adjacency(numNodes);
+  for (size_t i = 0; i < comps.size(); ++i) {
+    unknowns[i] = comps[i]->getUnknowns();
+    for (int a : unknowns[i]) {
+      for (int b : unknowns[i]) {
+        if (a != b && a < numNodes && b < numNodes) {
+          adjacency[a].emplace_back(b);
+        }
+      }
+    }
+  }
+
+  // Grow each partition breadth-first so that it holds a connected region of
+  // roughly numNodes / count nodes, which keeps the boundaries small.
+  vector<int> owner(numUnknowns, -1);
+  size_t target = (numNodes + count - 1) / count;
+  int current = 0;
+  size_t filled = 0;
+  auto assign = [&](int node) {
+    if (filled >= target && current < count - 1) {
+      current++;
+      filled = 0;
+    }
+    owner[node] = current;
+    filled++;
+  };
+  for (int seed = 0; seed < numNodes; ++seed) {
+    if (owner[seed] >= 0) {
+      continue;
+    }
+    std::queue<int> queue;
+    assign(seed);
+    queue.push(seed);
+    while (!queue.empty()) {
+      int node = queue.front();
+      queue.pop();
+      for (int next : adjacency[node]) {
+        if (owner[next] < 0) {
+          assign(next);
+          queue.push(next);
+        }
+      }
+    }
+  }
+
+  // Branch currents go with the first node of the component owning them
+  for (const auto &u : unknowns) {
+    int home = -1;
+    for (int x : u) {
+      if (x < numNodes) {
+        home = owner[x];
+        break;
+      }
+    }
+    for (int x : u) {
+      if (x >= numNodes && owner[x] < 0) {
+        owner[x] = std::max(home, 0);
+      }
+    }
+  }
+
+  partitions.resize(count);
+  for (int x = 0; x < numUnknowns; ++x) {
+    if (owner[x] < 0) {
+      owner[x] = 0;
+    }
+    partitions[owner[x]].newton.rows.emplace_back(x);
+  }
+
+  // Every partition gets its own copy of each component touching one of its
+  // unknowns, so that partitions never share component state.
+  for (size_t i = 0; i < comps.size(); ++i) {
+    std::set<int> touched;
+    for (int x : unknowns[i]) {
+      touched.insert(owner[x]);
+    }
+    for (int p : touched) {
+      Partition &part = partitions[p];
+      if ((int)i == input) {
+        part.input = part.newton.models.size();
+      }
+      part.sources.emplace_back(i);
+      part.newton.models.emplace_back(comps[i]->clone());
+      part.checkpoint.emplace_back(comps[i]->clone());
+    }
+  }
+
+  for (int p = 0; p < count; ++p) {
+    Partition &part = partitions[p];
+    std::set<int> boundary;
+    for (int i : part.sources) {
+      for (int x : unknowns[i]) {
+        if (owner[x] != p) {
+          boundary.insert(x);
+        }
+      }
+    }
+    part.newton.known.assign(boundary.begin(), boundary.end());
+    part.newton.resize(numUnknowns);
+    part.V = Eigen::VectorXd::Zero(numUnknowns);
+  }
+  partitions.erase(std::remove_if(partitions.begin(), partitions.end(),
+                                  [](const Partition &p) {
+                                    return p.newton.rows.empty();
+                                  }),
+                   partitions.end());
+
+  waveform = Eigen::MatrixXd::Zero(numUnknowns, options.windowSize);
+  nextWaveform = Eigen::MatrixXd::Zero(numUnknowns, options.windowSize);
+  lastSolution = Eigen::VectorXd::Zero(numUnknowns);
+}
+
+void WaveformRelaxationSolver::restore(Partition &p) {
+  for (size_t i = 0; i < p.newton.models.size(); ++i) {
+    p.newton.models[i]->copyState(*p.checkpoint[i]);
+  }
+}
+
+void WaveformRelaxationSolver::solveWindow(Partition &p,
+                                           const Eigen::MatrixXd &in,
+                                           Eigen::MatrixXd &out, double start,
+                                           double dt, const float *input,
+                                           size_t numSamples) {
+  VoltageSourceModel *v =
+      p.input >= 0
+          ? static_cast<VoltageSourceModel *>(p.newton.models[p.input])
+          : nullptr;
+  const vector<int> &owned = p.newton.rows;
+  const Eigen::VectorXd &solution = p.newton.system.previous;
+  double t = start;
+  p.delta = 0.0;
+
+  for (size_t k = 0; k < numSamples; ++k) {
+    for (int x : p.newton.known) {
+      p.V(x) = in(x, k);
+    }
+    if (v) {
+      v->setVoltage(input[k]);
+    }
+    p.newton.solve(p.V, t, dt, Circuit::MAX_ITERATIONS);
+    for (size_t i = 0; i < owned.size(); ++i) {
+      int row = owned[i];
+      p.delta = std::max(p.delta, std::abs(solution(i) - in(row, k)));
+      out(row, k) = solution(i);
+    }
+    t += dt;
+  }
+}
+
+void WaveformRelaxationSolver::solveJob(void *solver, size_t index) {
+  auto *self = static_cast<WaveformRelaxationSolver *>(solver);
+  self->solveWindow(self->partitions[index], self->waveform,
+                    self->nextWaveform, self->windowStart, self->windowDt,
+                    self->windowInput, self->windowSamples);
+}
+
+void WaveformRelaxationSolver::solveTransient(double start, double dt,
+                                              size_t numSamples, int input,
+                                              int outputL, int outputR,
+                                              float **inputBuffer,
+                                              float **outputBuffer) {
+  int numNodes = circuit->getNumStates();
+  if (Circuit::isNodeGround(outputL) || outputL >= numNodes ||
+      Circuit::isNodeGround(outputR) || outputR >= numNodes) {
+    return;
+  }
+  const vector<ComponentModel *> &comps = circuit->getComponents();
+  if (input < 0 || input >= (int)comps.size() ||
+      !dynamic_cast<VoltageSourceModel *>(comps[input])) {
+    throw std::runtime_error("Input is not a voltage source.\n");
+  }
+  if (partitions.empty() || input != inputNode ||
+      numUnknowns != circuit->getLastIndex()) {
+    buildPartitions(input);
+  }
+
+  double t = start;
+  for (size_t offset = 0; offset < numSamples; offset += options.windowSize) {
+    size_t n = std::min(options.windowSize, numSamples - offset);
+    const float *in = inputBuffer[0] + offset;
+
+    // Initial guess: every unknown holds its value from the previous window
+    for (size_t k = 0; k < n; ++k) {
+      waveform.col(k) = lastSolution;
+    }
+    for (auto &p : partitions) {
+      for (size_t i = 0; i < p.newton.models.size(); ++i) {
+        p.checkpoint[i]->copyState(*p.newton.models[i]);
+      }
+    }
+
+    lastSweeps = 0;
+    for (int sweep = 0; sweep < options.maxSweeps; ++sweep) {
+      if (sweep > 0) {
+        for (auto &p : partitions) {
+          restore(p);
+        }
+      }
+      lastSweeps++;
+
+      if (options.scheme == RelaxationScheme::GaussJacobi) {
+        windowInput = in;
+        windowStart = t;
+        windowDt = dt;
+        windowSamples = n;
+        WorkerPool::instance().run(partitions.size(),
+                                   &WaveformRelaxationSolver::solveJob, this);
+        waveform.swap(nextWaveform);
+      } else {
+        for (auto &p : partitions) {
+          solveWindow(p, waveform, waveform, t, dt, in, n);
+        }
+      }
+
+      double delta = 0.0;
+      for (const auto &p : partitions) {
+        delta = std::max(delta, p.delta);
+      }
+      // A single partition has no boundary to relax
+      if (partitions.size() == 1 || delta < options.tolerance) {
+        break;
+      }
+    }
+
+    lastSolution = waveform.col(n - 1);
+    for (size_t k = 0; k < n; ++k) {
+      outputBuffer[0][offset + k] = waveform(outputL, k);
+      outputBuffer[1][offset + k] = waveform(outputR, k);
+    }
+    t += n * dt;
+  }
+}
+
+int WaveformRelaxationSolver::getNumPartitions() const {
+  return partitions.size();
+}
+
+int WaveformRelaxationSolver::getLastSweepCount() const { return lastSweeps; }
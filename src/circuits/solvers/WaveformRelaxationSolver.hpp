@@ -0,0 +1,71 @@
+#pragma once
+
+#include "../Circuit.hpp"
+#include "../models/VoltageSourceModel.hpp"
+#include <eigen3/Eigen/Dense>
+
+// Waveform relaxation: the circuit is split into partitions that are each
+// simulated over a whole time window on their own, using the waveforms of the
+// other partitions' unknowns from the previous sweep. Sweeps are repeated
+// until the boundary waveforms stop moving.
+
+enum class RelaxationScheme {
+  // Partitions run concurrently on the previous sweep's waveforms, on the
+  // worker pool
+  GaussJacobi,
+  GaussSeidel, // Partitions run one after the other on the latest waveforms
+};
+
+struct WaveformRelaxationOptions {
+  int partitions = 2;
+  size_t windowSize = 256;
+  int maxSweeps = 50;
+  double tolerance = 1e-6; // Max change of any unknown between two sweeps
+  RelaxationScheme scheme = RelaxationScheme::GaussJacobi;
+};
+
+class WaveformRelaxationSolver {
+  struct Partition {
+    // Rows: the unknowns solved by this partition. Known: those read from
+    // the other partitions. Models: copies of the components touching them.
+    Circuit::Subsystem newton;
+    vector<int> sources; // Indices of the circuit components we hold copies of
+    vector<ComponentModel *> checkpoint; // Component states at window start
+    int input = -1;                      // Index of the input in the models
+    Eigen::VectorXd V;
+    double delta = 0.0;
+  };
+
+  Circuit *circuit;
+  WaveformRelaxationOptions options;
+  int numUnknowns = 0;
+  int inputNode = -1;
+  vector<Partition> partitions;
+  Eigen::MatrixXd waveform; // One column per sample of the current window
+  Eigen::MatrixXd nextWaveform;
+  Eigen::VectorXd lastSolution;
+  int lastSweeps = 0;
+  // The window being swept, for the pool's jobs
+  const float *windowInput = nullptr;
+  double windowStart = 0.0;
+  double windowDt = 0.0;
+  size_t windowSamples = 0;
+
+  void buildPartitions(int input);
+  void clearPartitions();
+  void restore(Partition &p);
+  void solveWindow(Partition &p, const Eigen::MatrixXd &in,
+                   Eigen::MatrixXd &out, double start, double dt,
+                   const float *input, size_t numSamples);
+  static void solveJob(void *solver, size_t index);
+
+public:
+  WaveformRelaxationSolver(Circuit *c, const WaveformRelaxationOptions &opts =
+                                           WaveformRelaxationOptions());
+  ~WaveformRelaxationSolver();
+  void solveTransient(double start, double dt, size_t numSamples,
+                      int inputNode, int outputL, int outputR,
+                      float **inputBuffer, float **outputBuffer);
+  int getNumPartitions() const;
+  int getLastSweepCount() const;
+};
@@ -1,11 +1,14 @@
 #include "Application.hpp"
-#include "../audio/processors/ChainProcessor.hpp"
+#include "../audio/engine/WorkerPool.hpp"
 #include "../audio/processors/FilePlayer.hpp"
 #include "../audio/processors/GainProcessor.hpp"
+#include "../audio/processors/GraphProcessor.hpp"
 #include "../audio/processors/ScopeProcessor.hpp"
 #include "../audio/processors/SwitchProcessor.hpp"
 #include "../audio/processors/customs/PedalProcessors.hpp"
 #include "../circuits/ComponentRegistry.hpp"
+#include "CircuitCache.hpp"
+#include "Trace.hpp"
 #include <GL/glew.h>
 #include <SDL2/SDL.h>
 #include <SDL_error.h>
@@ -13,6 +16,8 @@
 #include <SDL_keyboard.h>
 #include <SDL_render.h>
 #include <SDL_video.h>
+#include <algorithm>
+#include <chrono>
 #include <eigen3/Eigen/src/Core/Matrix.h>
 #include <imgui.h>
 #include <imgui_impl_sdl2.h>
@@ -35,23 +40,34 @@ void Application::init() {
   this->initSDL2();
   this->initImGui();
   printf("[INFO]: Application initialization successful !\n");
-  ChainProcessor *processor = new ChainProcessor();
-  // processor->addProcessor(new FilePlayer());
-  processor->addProcessor(new ScopeProcessor());
-
-  ChainProcessor *circuitChain = new ChainProcessor();
-  circuitChain->addProcessor(new GainProcessor());
-  circuitBox = new ChainProcessor();
-  circuitBox->addProcessor(PedalProcessors::FuzzProcessor());
-  circuitChain->addProcessor(circuitBox);
-  SwitchProcessor *sw = new SwitchProcessor(circuitChain);
-
-  processor->addProcessor(sw);
-  processor->addProcessor(new GainProcessor());
-  processor->addProcessor(new ScopeProcessor());
+  unsigned cores = std::thread::hardware_concurrency();
+  WorkerPool::instance().setThreads(cores > 1 ? std::min(cores - 1, 3u) : 0);
+
+  GraphProcessor *circuitChain = new GraphProcessor();
+  int inputGain = circuitChain->addNode(new GainProcessor());
+  CircuitProcessor *fuzz = PedalProcessors::FuzzProcessor();
+  fuzz->setBudget(CIRCUIT_BUDGET);
+  circuitSlot = new SwapProcessor(fuzz);
+  int circuit = circuitChain->addNode(circuitSlot);
+  circuitChain->connect(GraphProcessor::INPUT, inputGain);
+  circuitChain->connect(inputGain, circuit);
+  circuitChain->connect(circuit, GraphProcessor::OUTPUT);
+
+  GraphProcessor *processor = new GraphProcessor();
+  // int player = processor->addNode(new FilePlayer());
+  int inputScope = processor->addNode(new ScopeProcessor());
+  int sw = processor->addNode(new SwitchProcessor(circuitChain));
+  int outputGain = processor->addNode(new GainProcessor());
+  int outputScope = processor->addNode(new ScopeProcessor());
+  processor->connect(GraphProcessor::INPUT, inputScope);
+  processor->connect(inputScope, sw);
+  processor->connect(sw, outputGain);
+  processor->connect(outputGain, outputScope);
+  processor->connect(outputScope, GraphProcessor::OUTPUT);
   this->engine = new AudioEngine(processor);
 
   registerComponents();
+  CircuitCache::instance().setDirectory(CircuitCache::defaultDirectory());
   editor = Editor();
 }
 
@@ -138,6 +154,8 @@ void Application::renderComponentView() {
 }
 
 void Application::renderFrame() {
+  Trace::nameThread("UI");
+  Trace::Span span("Application::renderFrame");
 
   ImGuiViewport *viewport = ImGui::GetMainViewport();
   ImGui::SetNextWindowPos(viewport->Pos);
@@ -192,6 +210,21 @@ void Application::renderFrame() {
           }
         }
       }
+      if (!Trace::isRecording() && ImGui::MenuItem("Start trace")) {
+        Trace::start();
+      }
+      // Every solver iteration, which only leaves room for the last moments
+      if (!Trace::isRecording() && ImGui::MenuItem("Start detailed trace")) {
+        Trace::start(1 << 17, true);
+      }
+      if (Trace::isRecording() && ImGui::MenuItem("Save trace")) {
+        const char *filePath = tinyfd_saveFileDialog(
+            "Save trace", "trace.json", 0, nullptr, "Chrome trace");
+        if (filePath && !Trace::save(filePath)) {
+          tinyfd_messageBox("Error", "Failed to save trace!", "ok", "error",
+                            1);
+        }
+      }
       if (ImGui::MenuItem("Exit"))
         this->isRunning = false;
       ImGui::EndMenu();
@@ -201,12 +234,29 @@ void Application::renderFrame() {
   ImGui::End();
 
   ImGui::Begin("Processors", nullptr);
+  const LoadStats &load = engine->getLoad().read();
+  XrunCounts xruns = engine->getXruns();
+  ImGui::Text("DSP load %.1f%% avg, %.1f%% p99, %.1f%% max", load.mean,
+              load.p99, load.max);
+  ImGui::Text("Xruns: %zu input under, %zu input over, %zu output under, "
+              "%zu output over",
+              xruns.inputUnderflow, xruns.inputOverflow,
+              xruns.outputUnderflow, xruns.outputOverflow);
   ImGui::Separator();
   engine->getProcessor()->render();
   if (ImGui::Button("Play")) {
     this->onPlayPressed();
   }
+  ImGui::SameLine();
+  if (circuitBuild.valid()) {
+    ImGui::ProgressBar(buildProgress->load(), ImVec2(-1, 0), "Building");
+  } else if (ImGui::Button("Rebuild circuit")) {
+    this->rebuildCircuit();
+  }
   ImGui::End();
+  installBuiltCircuit();
+  circuitSlot->collect();
+  renderAudioSettings();
   editor.render();
   ImGui::SetNextWindowDockID(dockspace_id, ImGuiCond_FirstUseEver);
   renderComponentView();
@@ -246,7 +296,14 @@ void Application::shutdownSDL2() {
 }
 
 void Application::shutdown() {
+  if (circuitBuild.valid()) {
+    try {
+      delete circuitBuild.get();
+    } catch (const std::exception &) {
+    }
+  }
   this->engine->stop();
+  editor.setLiveCircuit(nullptr);
   delete engine;
   printf("[INFO]: Shutting down application...\n");
   this->shutdownImGui();
@@ -268,10 +325,128 @@ void Application::handleEvent(SDL_Event event) {
   editor.handleEvent(event);
 }
 
+void Application::renderAudioSettings() {
+  ImGui::Begin("Audio Settings", nullptr);
+  AudioConfig config = engine->getConfig();
+  bool changed = false;
+
+  bool refresh = ImGui::Button("Refresh devices");
+  if (refresh || audioDevices.empty()) {
+    audioDevices = engine->listDevices();
+  }
+  auto deviceCombo = [&](const char *label, int &selected, bool input) {
+    string current = "Default";
+    for (const auto &d : audioDevices) {
+      if (d.index == selected) {
+        current = d.name;
+      }
+    }
+    if (ImGui::BeginCombo(label, current.c_str())) {
+      if (ImGui::Selectable("Default", selected < 0)) {
+        selected = -1;
+        changed = true;
+      }
+      for (const auto &d : audioDevices) {
+        int channels = input ? d.maxInputChannels : d.maxOutputChannels;
+        if (channels > 0 &&
+            ImGui::Selectable(d.name.c_str(), d.index == selected)) {
+          selected = d.index;
+          changed = true;
+        }
+      }
+      ImGui::EndCombo();
+    }
+  };
+  deviceCombo("Input", config.inputDevice, true);
+  deviceCombo("Output", config.outputDevice, false);
+
+  string rate = std::to_string((int)config.sampleRate) + " Hz";
+  if (ImGui::BeginCombo("Sample rate", rate.c_str())) {
+    for (double r : AudioEngine::getSupportedSampleRates()) {
+      string label = std::to_string((int)r) + " Hz";
+      if (ImGui::Selectable(label.c_str(), r == config.sampleRate)) {
+        config.sampleRate = r;
+        changed = true;
+      }
+    }
+    ImGui::EndCombo();
+  }
+
+  string frames = std::to_string(config.framesPerBuffer);
+  if (ImGui::BeginCombo("Buffer size", frames.c_str())) {
+    for (unsigned long n = AudioEngine::MIN_FRAMES_PER_BUFFER;
+         n <= AudioEngine::MAX_FRAMES_PER_BUFFER; n *= 2) {
+      if (ImGui::Selectable(std::to_string(n).c_str(),
+                            n == config.framesPerBuffer)) {
+        config.framesPerBuffer = n;
+        changed = true;
+      }
+    }
+    ImGui::EndCombo();
+  }
+  string block =
+      config.blockSize ? std::to_string(config.blockSize) : string("Host");
+  if (ImGui::BeginCombo("Block size", block.c_str())) {
+    if (ImGui::Selectable("Host", config.blockSize == 0)) {
+      config.blockSize = 0;
+      changed = true;
+    }
+    for (unsigned long n = AudioEngine::MIN_FRAMES_PER_BUFFER; n <= 128;
+         n *= 2) {
+      if (ImGui::Selectable(std::to_string(n).c_str(),
+                            n == config.blockSize)) {
+        config.blockSize = n;
+        changed = true;
+      }
+    }
+    ImGui::EndCombo();
+  }
+  if (unsigned long latency = engine->getBlockLatency()) {
+    ImGui::SameLine();
+    ImGui::TextDisabled("+%lu frames", latency);
+  }
+  changed |= ImGui::Checkbox("Low latency", &config.lowLatency);
+
+  if (changed) {
+    try {
+      engine->setConfig(config);
+    } catch (const std::exception &e) {
+      this->isAudioPlaying = false;
+      tinyfd_messageBox("Error", e.what(), "ok", "error", 1);
+    }
+  }
+  ImGui::End();
+}
+
+// The build runs on a worker thread, installBuiltCircuit picks it up
+void Application::rebuildCircuit() {
+  if (circuitBuild.valid()) {
+    return;
+  }
+  buildProgress = std::make_shared<std::atomic<float>>(0.0f);
+  circuitBuild = editor.toCircuitAsync(buildProgress);
+}
+
+// Safe while playing: the audio thread crossfades to the new circuit
+void Application::installBuiltCircuit() {
+  if (!circuitBuild.valid() ||
+      circuitBuild.wait_for(std::chrono::seconds(0)) !=
+          std::future_status::ready) {
+    return;
+  }
+  try {
+    CircuitProcessor *circuit = circuitBuild.get();
+    circuit->setBudget(CIRCUIT_BUDGET);
+    circuitSlot->publish(circuit);
+    editor.setLiveCircuit(circuit);
+  } catch (const std::exception &e) {
+    tinyfd_messageBox("Error", e.what(), "ok", "error", 1);
+  }
+}
+
 void Application::onPlayPressed() {
-  circuitBox->clear();
-  circuitBox->addProcessor(editor.toCircuit());
   if (!this->isAudioPlaying) {
+    rebuildCircuit();
     this->isAudioPlaying = true;
     engine->start();
   } else {
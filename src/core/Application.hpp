@@ -1,7 +1,8 @@
 #pragma once
 
 #include "../audio/engine/AudioEngine.hpp"
-#include "../audio/processors/ChainProcessor.hpp"
+#include "../audio/processors/GraphProcessor.hpp"
+#include "../audio/processors/SwapProcessor.hpp"
 #include "Editor.hpp"
 #include <SDL_video.h>
 #include <eigen3/Eigen/Dense>
@@ -21,10 +22,16 @@ protected:
   SDL_Renderer *renderer;
   AudioEngine *engine = nullptr;
   Editor editor;
-  ChainProcessor *circuitBox;
+  SwapProcessor *circuitSlot; // Holds the circuit built from the editor
+  std::future<CircuitProcessor *> circuitBuild;
+  std::shared_ptr<std::atomic<float>> buildProgress;
+  vector<AudioDeviceInfo> audioDevices;
 
   bool isAudioPlaying = false;
   static Application *instance;
+  // Of each buffer, for the live circuit, leaving the rest to the processors
+  // around it
+  static constexpr float CIRCUIT_BUDGET = 0.7f;
 
 public:
   Application();
@@ -46,6 +53,9 @@ private:
   void renderFrame();
   static const char *getTitle();
   void onPlayPressed();
+  void rebuildCircuit();
+  void installBuiltCircuit();
   void onBrowsePressed();
   void renderComponentView();
+  void renderAudioSettings();
 };
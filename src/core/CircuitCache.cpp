@@ -0,0 +1,232 @@
+#include "CircuitCache.hpp"
+#include "../circuits/ComponentRegistry.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+json CompiledCircuit::toJson() const {
+  json elementsArray = json::array();
+  for (const auto &element : elements) {
+    elementsArray.push_back({{"id", element.id},
+                             {"type", element.type},
+                             {"data", element.data},
+                             {"pins", element.pins},
+                             {"slow", element.slow}});
+  }
+  return {{"nodes", numNodes}, {"elements", elementsArray}};
+}
+
+CompiledCircuit CompiledCircuit::fromJson(const json &data) {
+  CompiledCircuit circuit;
+  circuit.numNodes = data.at("nodes").get<int>();
+  if (circuit.numNodes < 0) {
+    throw std::runtime_error("Negative node count");
+  }
+  for (const auto &e : data.at("elements")) {
+    Element element = {e.at("id").get<int>(), e.at("type").get<string>(),
+                       e.at("data"), e.at("pins").get<vector<int>>(),
+                       e.at("slow").get<bool>()};
+    // The hash only covers the schematic, not this: pins go straight into
+    // the stamps, so they must fit the factory and the matrix
+    ComponentFactory *factory = ComponentRegistry::getComponent(element.type);
+    if (element.pins.size() != factory->getPins().size()) {
+      throw std::runtime_error("Wrong pin count for " + element.type);
+    }
+    for (int pin : element.pins) {
+      if (pin < -1 || pin >= circuit.numNodes) {
+        throw std::runtime_error("Pin " + std::to_string(pin) + " of " +
+                                 element.type + " is not a node");
+      }
+    }
+    circuit.elements.push_back(element);
+  }
+  return circuit;
+}
+
+CircuitCache &CircuitCache::instance() {
+  static CircuitCache cache;
+  return cache;
+}
+
+uint64_t CircuitCache::hash(const Netlist &netlist) {
+  vector<const PlacedComponent *> components;
+  for (const auto &comp : netlist.components) {
+    components.push_back(&comp);
+  }
+  std::sort(components.begin(), components.end(),
+            [](const PlacedComponent *a, const PlacedComponent *b) {
+              return a->id < b->id;
+            });
+  json canonical = json::array();
+  canonical.push_back(CompiledCircuit::VERSION);
+  json componentsArray = json::array();
+  for (const auto *comp : components) {
+    componentsArray.push_back({comp->id, comp->type, comp->position.x,
+                               comp->position.y, comp->angle, comp->data,
+                               comp->slow});
+  }
+  canonical.push_back(componentsArray);
+
+  // Node families stand for the cables: two drawings that connect the same
+  // pins give the same families once sorted
+  vector<vector<std::pair<int, int>>> families = netlist.nodeFamilies;
+  for (auto &family : families) {
+    std::sort(family.begin(), family.end());
+    family.erase(std::unique(family.begin(), family.end()), family.end());
+  }
+  std::sort(families.begin(), families.end());
+  canonical.push_back(families);
+
+  // FNV-1a
+  uint64_t h = 14695981039346656037ull;
+  for (unsigned char c : canonical.dump()) {
+    h ^= c;
+    h *= 1099511628211ull;
+  }
+  return h;
+}
+
+string CircuitCache::toHex(uint64_t key) {
+  std::ostringstream out;
+  out << std::hex;
+  out.width(16);
+  out.fill('0');
+  out << key;
+  return out.str();
+}
+
+json CircuitCache::toJson(uint64_t key, const CompiledCircuit &circuit) {
+  return {{"version", CompiledCircuit::VERSION},
+          {"hash", toHex(key)},
+          {"circuit", circuit.toJson()}};
+}
+
+std::shared_ptr<const CompiledCircuit> CircuitCache::fromJson(const json &data,
+                                                              uint64_t key) {
+  if (data.at("version").get<int>() != CompiledCircuit::VERSION ||
+      data.at("hash").get<string>() != toHex(key)) {
+    return nullptr;
+  }
+  return std::make_shared<const CompiledCircuit>(
+      CompiledCircuit::fromJson(data.at("circuit")));
+}
+
+std::filesystem::path CircuitCache::filePath(uint64_t key) const {
+  return directory / (toHex(key) + ".json");
+}
+
+void CircuitCache::remember(uint64_t key,
+                            std::shared_ptr<const CompiledCircuit> circuit) {
+  entries[key] = {circuit, ++uses};
+  if (entries.size() > MAX_ENTRIES) {
+    auto oldest = std::min_element(
+        entries.begin(), entries.end(), [](const auto &a, const auto &b) {
+          return a.second.lastUse < b.second.lastUse;
+        });
+    entries.erase(oldest);
+  }
+}
+
+std::shared_ptr<const CompiledCircuit> CircuitCache::find(uint64_t key) {
+  std::lock_guard<std::mutex> lock(mutex);
+  auto it = entries.find(key);
+  if (it != entries.end()) {
+    it->second.lastUse = ++uses;
+    return it->second.circuit;
+  }
+  if (directory.empty()) {
+    return nullptr;
+  }
+  std::ifstream file(filePath(key));
+  if (!file.is_open()) {
+    return nullptr;
+  }
+  try {
+    auto circuit = fromJson(json::parse(file), key);
+    if (circuit) {
+      remember(key, circuit);
+      // Recently used on disk too, so that prune keeps it
+      std::error_code error;
+      std::filesystem::last_write_time(
+          filePath(key), std::filesystem::file_time_type::clock::now(), error);
+    }
+    return circuit;
+  } catch (const std::exception &e) {
+    std::cerr << "Ignoring cached circuit " << filePath(key) << ": "
+              << e.what() << std::endl;
+    return nullptr;
+  }
+}
+
+void CircuitCache::insert(uint64_t key,
+                          std::shared_ptr<const CompiledCircuit> circuit) {
+  std::lock_guard<std::mutex> lock(mutex);
+  remember(key, circuit);
+  if (directory.empty()) {
+    return;
+  }
+  // Written aside and renamed, so that a reader never sees half a file
+  std::error_code error;
+  std::filesystem::create_directories(directory, error);
+  std::filesystem::path path = filePath(key);
+  std::filesystem::path temporary = path;
+  temporary += ".tmp";
+  {
+    std::ofstream file(temporary);
+    if (!file.is_open()) {
+      return;
+    }
+    file << toJson(key, *circuit).dump();
+  }
+  std::filesystem::rename(temporary, path, error);
+  prune();
+}
+
+void CircuitCache::prune() {
+  using Clock = std::filesystem::file_time_type;
+  vector<std::pair<Clock, std::filesystem::path>> files;
+  std::error_code error;
+  for (const auto &file :
+       std::filesystem::directory_iterator(directory, error)) {
+    if (file.path().extension() != ".json") {
+      continue;
+    }
+    Clock time = file.last_write_time(error);
+    if (!error) {
+      files.emplace_back(time, file.path());
+    }
+  }
+  if (files.size() <= MAX_ENTRIES) {
+    return;
+  }
+  std::sort(files.begin(), files.end(),
+            [](const auto &a, const auto &b) { return a.first > b.first; });
+  for (size_t i = MAX_ENTRIES; i < files.size(); i++) {
+    std::filesystem::remove(files[i].second, error);
+  }
+}
+
+void CircuitCache::setDirectory(const std::filesystem::path &path) {
+  std::lock_guard<std::mutex> lock(mutex);
+  directory = path;
+  if (!directory.empty()) {
+    prune();
+  }
+}
+
+std::filesystem::path CircuitCache::defaultDirectory() {
+  const char *cacheHome = getenv("XDG_CACHE_HOME");
+  const char *home = getenv("HOME");
+  std::filesystem::path base;
+  if (cacheHome && *cacheHome) {
+    base = cacheHome;
+  } else if (home && *home) {
+    base = std::filesystem::path(home) / ".cache";
+  } else {
+    return std::filesystem::temp_directory_path() / "logiisound" / "circuits";
+  }
+  return base / "logiisound" / "circuits";
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "Editor.hpp"
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <vector>
+
+using json = nlohmann::json;
+using std::string;
+using std::vector;
+
+// A netlist with its nodes numbered: everything Editor::compile works out
+// from the schematic before it creates the models. Ground symbols are gone,
+// every other component keeps its editor id.
+struct CompiledCircuit {
+  // Bumped whenever compiling would give a different result, so that
+  // artifacts from older versions stop matching
+  static const int VERSION = 2;
+
+  struct Element {
+    int id;
+    string type;
+    json data;
+    vector<int> pins; // Node per factory pin, -1 for ground
+    bool slow;
+  };
+  int numNodes = 0;
+  vector<Element> elements;
+
+  json toJson() const;
+  // Throws when an element's pins don't match its factory or the nodes
+  static CompiledCircuit fromJson(const json &data);
+};
+
+// Compiled circuits keyed by a hash of the schematic they came from, so that
+// playing a circuit again skips the netlist analysis. Entries are kept in
+// memory and, once a directory is set, as one JSON file each on disk; both
+// keep only the MAX_ENTRIES most recently used. Any thread may use it.
+class CircuitCache {
+  static const size_t MAX_ENTRIES = 32;
+
+  struct Entry {
+    std::shared_ptr<const CompiledCircuit> circuit;
+    uint64_t lastUse;
+  };
+  std::mutex mutex;
+  std::map<uint64_t, Entry> entries;
+  uint64_t uses = 0;
+  std::filesystem::path directory; // Empty: memory only
+
+  CircuitCache() = default;
+  std::filesystem::path filePath(uint64_t key) const;
+  void remember(uint64_t key, std::shared_ptr<const CompiledCircuit> circuit);
+  // Deletes all but the MAX_ENTRIES most recently used files in directory
+  void prune();
+
+public:
+  static CircuitCache &instance();
+  // Same value for the same components and connections, whatever order the
+  // editor holds them in and however the cables are drawn
+  static uint64_t hash(const Netlist &netlist);
+  static string toHex(uint64_t key);
+  // An entry as stored on disk and in saved circuits. fromJson gives nullptr
+  // when the entry belongs to another key or compiler version, and throws
+  // when it is malformed.
+  static json toJson(uint64_t key, const CompiledCircuit &circuit);
+  static std::shared_ptr<const CompiledCircuit> fromJson(const json &data,
+                                                         uint64_t key);
+
+  // nullptr on a miss
+  std::shared_ptr<const CompiledCircuit> find(uint64_t key);
+  void insert(uint64_t key, std::shared_ptr<const CompiledCircuit> circuit);
+  void setDirectory(const std::filesystem::path &path);
+  // $XDG_CACHE_HOME/logiisound/circuits, or under ~/.cache
+  static std::filesystem::path defaultDirectory();
+};
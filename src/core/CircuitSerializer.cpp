@@ -1,4 +1,5 @@
 #include "CircuitSerializer.hpp"
+#include "CircuitCache.hpp"
 #include <fstream>
 #include <iostream>
 
@@ -21,6 +22,14 @@ bool CircuitSerializer::saveCircuit(const Editor &editor,
     }
     circuitData["cables"] = cablesArray;
 
+    // A circuit that was played keeps its compiled netlist, so that loading
+    // it elsewhere doesn't have to analyse it again
+    uint64_t key = CircuitCache::hash(editor.getNetlist());
+    auto compiled = CircuitCache::instance().find(key);
+    if (compiled) {
+      circuitData["compiled"] = CircuitCache::toJson(key, *compiled);
+    }
+
     // Write to file
     std::ofstream file(filePath);
     if (!file.is_open()) {
@@ -69,6 +78,20 @@ bool CircuitSerializer::loadCircuit(Editor &editor, const string &filePath) {
       }
     }
 
+    // Ignored when the file was edited since, the hash no longer matches
+    if (circuitData.contains("compiled")) {
+      try {
+        uint64_t key = CircuitCache::hash(editor.getNetlist());
+        auto compiled = CircuitCache::fromJson(circuitData["compiled"], key);
+        if (compiled) {
+          CircuitCache::instance().insert(key, compiled);
+        }
+      } catch (const std::exception &e) {
+        std::cerr << "Ignoring compiled circuit in " << filePath << ": "
+                  << e.what() << std::endl;
+      }
+    }
+
     std::cout << "Circuit loaded from " << filePath << std::endl;
     return true;
   } catch (const std::exception &e) {
@@ -84,6 +107,9 @@ json CircuitSerializer::serializeComponent(const PlacedComponent &component) {
   comp["angle"] = component.angle;
   comp["id"] = component.id;
   comp["data"] = component.data;
+  if (component.slow) {
+    comp["slow"] = true;
+  }
   return comp;
 }
 
@@ -108,6 +134,7 @@ PlacedComponent CircuitSerializer::deserializeComponent(const json &data) {
   component.angle = data["angle"].get<float>();
   component.id = data["id"].get<int>();
   component.data = data["data"];
+  component.slow = data.value("slow", false);
   return component;
 }
 
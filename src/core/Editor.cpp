@@ -7,8 +7,10 @@
 #include "../circuits/factories/NonComponentFactory.hpp"
 #include "../circuits/models/VoltageSourceModel.hpp"
 #include "CableHelper.hpp"
+#include "CircuitCache.hpp"
 #include "CircuitSerializer.hpp"
 #include "Editor.hpp"
+#include "Trace.hpp"
 #include <SDL_events.h>
 #include <SDL_render.h>
 #include <cmath>
@@ -126,6 +128,8 @@ void Editor::render() {
     json &data = c.data;
     ImGui::LabelText("##editCompLabel", "Edit Component");
     ImGui::Separator();
+    // Takes effect the next time the circuit is built
+    ImGui::Checkbox("Slow (supply, bias)", &c.slow);
     for (auto &[k, v] : data.items()) {
       string s = k;
       if (s.length() > 0) {
@@ -140,6 +144,7 @@ void Editor::render() {
         // - Format specified directly in JSON ?
         // - Dynamic prefix
         string fmt = "%.1f ";
+        ImGuiSliderFlags flags = ImGuiSliderFlags_Logarithmic;
         if (s == "R") {
           fmt += " Ohms";
         } else if (s == "C") {
@@ -147,15 +152,30 @@ void Editor::render() {
           mult = 1e12;
         } else if (s == "V") {
           fmt += " V";
+        } else if (s == "Position") {
+          fmt = "%.2f";
+          flags = ImGuiSliderFlags_None;
         }
         float new_value = v["value"];
         new_value *= mult;
+        // Ctrl+click typing goes past the range otherwise
+        flags |= ImGuiSliderFlags_AlwaysClamp;
         ImGui::PushID((intptr_t)&v);
-        ImGui::SliderFloat("##", &new_value, mult * (float)v["min"],
-                           mult * (float)v["max"], fmt.c_str(),
-                           ImGuiSliderFlags_Logarithmic);
+        bool changed = ImGui::SliderFloat(
+            "##", &new_value, mult * (float)v["min"], mult * (float)v["max"],
+            fmt.c_str(), flags);
         ImGui::PopID();
-        v["value"] = new_value / mult;
+        CircuitParameter *parameter =
+            liveCircuit ? liveCircuit->getParameter(c.id, k) : nullptr;
+        bool valid = std::isfinite(new_value) &&
+                     (new_value > 0 || !parameter ||
+                      !parameter->isLogarithmic());
+        if (changed && valid) {
+          v["value"] = new_value / mult;
+          if (parameter) {
+            parameter->set(new_value / mult);
+          }
+        }
       } else if (v["value"].is_string() && v["values"].is_array() &&
                  !v["values"].empty()) {
         auto &vals = v["values"];
@@ -553,14 +573,51 @@ bool Editor::loadCircuit(const string &filePath) {
   return res;
 }
 
+void Editor::setLiveCircuit(CircuitProcessor *circuit) {
+  liveCircuit = circuit;
+}
+
+Netlist Editor::getNetlist() const { return {placedComponents, nodeFamilies}; }
+
+CircuitProcessor *Editor::toCircuit() { return compile(getNetlist()); }
+
+std::future<CircuitProcessor *>
+Editor::toCircuitAsync(std::shared_ptr<std::atomic<float>> progress) {
+  return std::async(std::launch::async,
+                    [netlist = getNetlist(), progress]() {
+                      Trace::nameThread("Circuit build");
+                      return compile(netlist, progress.get());
+                    });
+}
+
+CircuitProcessor *Editor::compile(const Netlist &netlist,
+                                  std::atomic<float> *progress) {
+  Trace::Span span("Editor::compile");
+  CircuitCache &cache = CircuitCache::instance();
+  uint64_t key = CircuitCache::hash(netlist);
+  std::shared_ptr<const CompiledCircuit> compiled = cache.find(key);
+  if (!compiled) {
+    compiled = std::make_shared<const CompiledCircuit>(
+        resolve(netlist, progress));
+    cache.insert(key, compiled);
+  }
+  CircuitProcessor *proc = instantiate(*compiled);
+  if (progress) {
+    progress->store(1.0f);
+  }
+  return proc;
+}
+
 // TODO: clean this mess up
-CircuitProcessor *Editor::toCircuit() {
+CompiledCircuit Editor::resolve(const Netlist &netlist,
+                                std::atomic<float> *progress) {
+  Trace::Span span("Editor::resolve");
   std::map<int, std::set<pair<int, int>>> nodeMap;
   std::vector<int> groundFamilies;
   nodeMap[-1] = std::set<pair<int, int>>();
   int nodeCount = 0;
   // First pooling all ground pins
-  for (const auto &comp : placedComponents) {
+  for (const auto &comp : netlist.components) {
     if (comp.type == "gnd") {
       const auto &c = ComponentRegistry::getComponent(comp.type);
       const auto &p = c->getPins()[0];
@@ -570,7 +627,7 @@ CircuitProcessor *Editor::toCircuit() {
       actualGridPos += comp.position;
       pair<int, int> pin = {actualGridPos.x, actualGridPos.y};
       int i = 0;
-      for (const auto &family : nodeFamilies) {
+      for (const auto &family : netlist.nodeFamilies) {
         bool in = false;
         for (const auto against : family) {
           if (pin.first == against.first && pin.second == against.second) {
@@ -590,7 +647,7 @@ CircuitProcessor *Editor::toCircuit() {
 
   // Then creating all Nodes
   int i = 0;
-  for (const auto &family : nodeFamilies) {
+  for (const auto &family : netlist.nodeFamilies) {
     // Make sure it is not connected to ground
     bool in = false;
     for (const auto &val : groundFamilies) {
@@ -611,10 +668,16 @@ CircuitProcessor *Editor::toCircuit() {
     i++;
   }
 
-  Circuit *circ = new Circuit(nodeCount);
-  CircuitProcessor *proc = new CircuitProcessor(circ);
-
-  for (const auto &comp : placedComponents) {
+  CompiledCircuit compiled;
+  compiled.numNodes = nodeCount;
+  size_t resolved = 0;
+  for (const auto &comp : netlist.components) {
+    if (progress) {
+      progress->store((float)resolved++ / netlist.components.size());
+    }
+    if (comp.type == "gnd") {
+      continue;
+    }
     ComponentFactory *factory = ComponentRegistry::getComponent(comp.type);
     vector<int> pinIndices;
     for (const auto &p : factory->getPins()) {
@@ -639,23 +702,36 @@ CircuitProcessor *Editor::toCircuit() {
             std::to_string(pin.second) + ")");
       }
     }
+    compiled.elements.push_back(
+        {comp.id, comp.type, comp.data, pinIndices, comp.slow});
+  }
+  return compiled;
+}
+
+CircuitProcessor *Editor::instantiate(const CompiledCircuit &compiled) {
+  Circuit *circ = new Circuit(compiled.numNodes);
+  // Build errors throw, the circuit goes with its processor
+  std::unique_ptr<CircuitProcessor> proc(new CircuitProcessor(circ));
+  int inputIndex = -1;
+
+  for (const auto &element : compiled.elements) {
+    ComponentFactory *factory = ComponentRegistry::getComponent(element.type);
+    const vector<int> &pinIndices = element.pins;
 
     bool inputFound = false;
     bool outputFound = false;
 
     if (instanceof<NonComponentFactory>(factory)) {
-      if (comp.type == "gnd") {
-        continue;
-      } else if (comp.type == "in") {
+      if (element.type == "in") {
         if (inputFound) {
           throw std::runtime_error("Mutliple input sources in circuit.");
         }
         inputFound = true;
         VoltageSourceModel *model =
             new VoltageSourceModel(0.0, pinIndices[0], -1);
-        int input = circ->addComponent(model);
-        proc->setInput(input);
-      } else if (comp.type == "out") {
+        inputIndex = circ->addComponent(model);
+        proc->setInput(inputIndex);
+      } else if (element.type == "out") {
         if (outputFound) {
           throw std::runtime_error("Mutliple outputs in circuit.");
         }
@@ -665,13 +741,40 @@ CircuitProcessor *Editor::toCircuit() {
     }
 
     ComponentModel *model =
-        factory->fromJson(comp.data, pinIndices.data(), pinIndices.size());
-    if (model != nullptr) {
-      circ->addComponent(model);
+        factory->fromJson(element.data, pinIndices.data(), pinIndices.size());
+    if (model == nullptr) {
+      continue;
+    }
+    int index = circ->addComponent(model);
+    if (element.slow) {
+      circ->setSlow(index);
+    }
+    // Every numeric value gets a handle, for the edit popup to change live
+    if (element.data.is_object()) {
+      for (const auto &[key, value] : element.data.items()) {
+        if (!value.is_object() || !value.contains("value") ||
+            !value["value"].is_number()) {
+          continue;
+        }
+        CircuitParameter *parameter = circ->getParameter(index, key);
+        if (parameter) {
+          proc->addParameter(element.id, key, parameter);
+        }
+      }
     }
   }
-
-  return proc;
+  // Solver buffers too, so that installing the circuit doesn't allocate them
+  circ->prepare();
+  // Checked here, solveTransient would throw on the audio thread
+  if (inputIndex >= 0) {
+    for (int u : circ->getComponents()[inputIndex]->getUnknowns()) {
+      if (circ->isSlowUnknown(u)) {
+        throw std::runtime_error(
+            "The input can't be part of the slow subnetwork.");
+      }
+    }
+  }
+  return proc.release();
 }
 
 void Editor::updateNodeFamilies() {
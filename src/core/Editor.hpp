@@ -2,7 +2,10 @@
 #include "../audio/processors/CircuitProcessor.hpp"
 #include "CableManager.hpp"
 #include "imgui_impl_sdl2.h"
+#include <atomic>
+#include <future>
 #include <imgui.h>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -24,8 +27,18 @@ struct PlacedComponent {
   float angle;
   int id;
   json data = nullptr;
+  bool slow = false; // Solved at the circuit's decimated rate, see Circuit
 };
 
+// What building a circuit needs from the editor, copied so that the build
+// can run on another thread while the user keeps editing
+struct Netlist {
+  vector<PlacedComponent> components;
+  vector<vector<pair<int, int>>> nodeFamilies;
+};
+
+struct CompiledCircuit;
+
 class Editor {
 
   double zoom = 1.0;
@@ -46,6 +59,7 @@ class Editor {
   CableManager manager;
   std::vector<PlacedComponent> placedComponents;
   std::vector<std::vector<pair<int, int>>> nodeFamilies;
+  CircuitProcessor *liveCircuit = nullptr;
 
   double getScaleFactor() const;
   void renderGrid();
@@ -100,5 +114,22 @@ public:
   void updateNodeFamilies();
   bool verifyNodeFamilies();
 
+  // The circuit playing, built from this editor earlier. Value edits go to
+  // it right away, other edits wait for the next build.
+  void setLiveCircuit(CircuitProcessor *circuit);
+
+  Netlist getNetlist() const;
   CircuitProcessor *toCircuit();
+  // Builds on a worker thread, progress goes from 0 to 1. The future rethrows
+  // build errors.
+  std::future<CircuitProcessor *>
+  toCircuitAsync(std::shared_ptr<std::atomic<float>> progress);
+  // Reuses the netlist analysis from CircuitCache when the same schematic
+  // was compiled before
+  static CircuitProcessor *compile(const Netlist &netlist,
+                                   std::atomic<float> *progress = nullptr);
+  // The two halves of compile: numbering the nodes, then creating the models
+  static CompiledCircuit resolve(const Netlist &netlist,
+                                 std::atomic<float> *progress = nullptr);
+  static CircuitProcessor *instantiate(const CompiledCircuit &compiled);
 };
@@ -0,0 +1,180 @@
+#include "Trace.hpp"
+#include <algorithm>
+#include <cxxabi.h>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <vector>
+
+namespace {
+
+struct Event {
+  const char *name;
+  const std::type_info *type;
+  int64_t start;
+  int64_t end;
+};
+
+// Written by the thread that claimed it, read by save()
+struct ThreadBuffer {
+  std::vector<Event> events;
+  std::atomic<uint64_t> head{0}; // Events written since it was claimed
+  std::atomic<const char *> name{nullptr};
+  // Threads inside record(). A thread that claims the buffer in a newer
+  // recording waits for the previous owner's last write before resetting it.
+  std::atomic<int> writers{0};
+};
+
+ThreadBuffer buffers[Trace::MAX_THREADS];
+size_t capacity = 0;
+int64_t epoch = 0;
+// Recording generation in the high half, buffers claimed in it in the low
+// half. start() moves to the next generation with no claims, and threads
+// claim and reset a buffer the first time they record in it.
+std::atomic<uint64_t> claims{1ull << 32};
+
+unsigned generationOf(uint64_t c) { return c >> 32; }
+int claimedIn(uint64_t c) { return (int)(c & 0xffffffffu); }
+
+thread_local int slot = -1;
+thread_local unsigned slotGeneration = 0;
+thread_local const char *threadName = nullptr;
+
+ThreadBuffer *current() {
+  uint64_t c = claims.load(std::memory_order_acquire);
+  if (slotGeneration != generationOf(c)) {
+    c = claims.fetch_add(1, std::memory_order_seq_cst);
+    slot = claimedIn(c);
+    slotGeneration = generationOf(c);
+    if (slot < Trace::MAX_THREADS) {
+      ThreadBuffer &buffer = buffers[slot];
+      while (buffer.writers.load(std::memory_order_seq_cst) > 0) {
+      }
+      buffer.head.store(0, std::memory_order_relaxed);
+      buffer.name.store(threadName, std::memory_order_relaxed);
+    }
+  }
+  if (slot >= Trace::MAX_THREADS || capacity == 0) {
+    return nullptr;
+  }
+  return &buffers[slot];
+}
+
+std::string typeName(const std::type_info *type) {
+  int status;
+  char *demangled =
+      abi::__cxa_demangle(type->name(), nullptr, nullptr, &status);
+  std::string name = status == 0 ? demangled : type->name();
+  free(demangled);
+  return name;
+}
+
+} // namespace
+
+std::atomic<bool> Trace::recording{false};
+std::atomic<bool> Trace::detailed{false};
+
+void Trace::record(const char *name, const std::type_info *type, int64_t start,
+                   int64_t end) {
+  ThreadBuffer *buffer = current();
+  if (!buffer) {
+    return;
+  }
+  buffer->writers.fetch_add(1, std::memory_order_seq_cst);
+  // Dropped when a new recording started since the buffer was claimed, as
+  // another thread may own it by now
+  if (generationOf(claims.load(std::memory_order_seq_cst)) == slotGeneration) {
+    uint64_t head = buffer->head.load(std::memory_order_relaxed);
+    buffer->events[head % capacity] = {name, type, start, end};
+    buffer->head.store(head + 1, std::memory_order_release);
+  }
+  buffer->writers.fetch_sub(1, std::memory_order_release);
+}
+
+void Trace::start(size_t eventsPerThread, bool detail) {
+  stop();
+  if (capacity == 0) {
+    capacity = std::max<size_t>(eventsPerThread, 1);
+    for (auto &buffer : buffers) {
+      buffer.events.resize(capacity);
+    }
+  }
+  epoch = now();
+  uint64_t c = claims.load(std::memory_order_relaxed);
+  claims.store((uint64_t)(generationOf(c) + 1) << 32,
+               std::memory_order_seq_cst);
+  detailed = detail;
+  recording = true;
+}
+
+void Trace::stop() {
+  recording = false;
+  detailed = false;
+}
+
+// The name goes to the thread's buffer when it claims one, so naming claims
+// nothing and lasts across recordings
+void Trace::nameThread(const char *name) {
+  threadName = name;
+  if (slotGeneration == generationOf(claims.load(std::memory_order_acquire)) &&
+      slot < Trace::MAX_THREADS) {
+    buffers[slot].name.store(name, std::memory_order_relaxed);
+  }
+}
+
+bool Trace::save(const std::string &filePath) {
+  stop();
+  std::ofstream file(filePath);
+  if (!file.is_open()) {
+    return false;
+  }
+  file << std::fixed << std::setprecision(3) << "{\"traceEvents\":[";
+  bool first = true;
+  auto separator = [&]() {
+    if (!first) {
+      file << ",\n";
+    }
+    first = false;
+  };
+  std::map<std::pair<const char *, const std::type_info *>, std::string> names;
+  auto spanName = [&](const Event &e) -> const std::string & {
+    auto it = names.find({e.name, e.type});
+    if (it == names.end()) {
+      std::string name = e.type ? typeName(e.type) + "::" + e.name : e.name;
+      it = names.emplace(std::make_pair(e.name, e.type), name).first;
+    }
+    return it->second;
+  };
+  int threads = std::min(claimedIn(claims.load()), MAX_THREADS);
+  for (int t = 0; t < threads && capacity > 0; ++t) {
+    ThreadBuffer &buffer = buffers[t];
+    const char *name = buffer.name.load();
+    if (name) {
+      separator();
+      file << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":"
+           << t + 1 << ",\"args\":{\"name\":\"" << name << "\"}}";
+    }
+
+    // A span that started before stop() may still be writing, so only keep
+    // the events it can't have overwritten while we copied
+    uint64_t head = buffer.head.load(std::memory_order_acquire);
+    uint64_t begin = head > capacity ? head - capacity : 0;
+    std::vector<Event> events;
+    for (uint64_t i = begin; i < head; ++i) {
+      events.push_back(buffer.events[i % capacity]);
+    }
+    uint64_t after = buffer.head.load(std::memory_order_acquire);
+    uint64_t valid = after > capacity ? after - capacity : 0;
+    for (uint64_t i = std::max(begin, valid); i < head; ++i) {
+      const Event &e = events[i - begin];
+      separator();
+      file << "{\"ph\":\"X\",\"name\":\"" << spanName(e)
+           << "\",\"pid\":1,\"tid\":" << t + 1
+           << ",\"ts\":" << (e.start - epoch) / 1000.0
+           << ",\"dur\":" << (e.end - e.start) / 1000.0 << "}";
+    }
+  }
+  file << "]}" << std::endl;
+  return file.good();
+}
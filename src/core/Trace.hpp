@@ -0,0 +1,71 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <typeinfo>
+
+// Timeline of what every thread was doing, saved as Chrome trace JSON for
+// chrome://tracing or ui.perfetto.dev. Each thread writes to its own ring
+// buffer without locking or allocating, so spans are safe on the audio
+// thread. A span costs one atomic load while nothing is being recorded.
+class Trace {
+  static std::atomic<bool> recording;
+  static std::atomic<bool> detailed;
+  static void record(const char *name, const std::type_info *type,
+                     int64_t start, int64_t end);
+
+public:
+  static const int MAX_THREADS = 16; // Threads past this are not recorded
+
+  static int64_t now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+  }
+  static bool isRecording() {
+    return recording.load(std::memory_order_relaxed);
+  }
+  static bool isDetailed() { return detailed.load(std::memory_order_relaxed); }
+  // Drops what was recorded before. The ring buffers are allocated by the
+  // first call, with room for the last `eventsPerThread` spans of each
+  // thread. `detail` also records the DetailSpans, which fire on every
+  // solver iteration and leave room for well under a second of history.
+  static void start(size_t eventsPerThread = 1 << 17, bool detail = false);
+  static void stop();
+  // Stops recording and writes the trace. Returns false if the file can't
+  // be written.
+  static bool save(const std::string &filePath);
+  // Label of the calling thread in the trace. The name must outlive it, a
+  // string literal is fine.
+  static void nameThread(const char *name);
+
+  class Span {
+    const char *name;
+    const std::type_info *type;
+    int64_t start;
+
+  public:
+    explicit Span(const char *name)
+        : name(name), type(nullptr), start(isRecording() ? now() : -1) {}
+    // Shown as Type::name, the type is only demangled when saving
+    Span(const char *name, const std::type_info &type)
+        : name(name), type(&type), start(isRecording() ? now() : -1) {}
+    ~Span() {
+      if (start >= 0) {
+        record(name, type, start, now());
+      }
+    }
+
+  protected:
+    Span(const char *name, bool enabled)
+        : name(name), type(nullptr), start(enabled ? now() : -1) {}
+  };
+
+  // Only recorded by a detailed trace, see start
+  class DetailSpan : public Span {
+  public:
+    explicit DetailSpan(const char *name) : Span(name, isDetailed()) {}
+  };
+};
@@ -0,0 +1,134 @@
+#include "OfflineRender.hpp"
+#include "../circuits/ComponentRegistry.hpp"
+#include "../core/Editor.hpp"
+#include "../core/Trace.hpp"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <sndfile.h>
+#include <sstream>
+
+CircuitProcessor *OfflineRender::loadCircuit(const string &filePath) {
+  // The registry and editor log their bookkeeping to stdout, which the tools
+  // keep for their own reports.
+  std::ostringstream editorLog;
+  std::streambuf *out = std::cout.rdbuf(editorLog.rdbuf());
+  if (ComponentRegistry::instance().getRegistry().empty()) {
+    registerComponents();
+  }
+  CircuitProcessor *proc = nullptr;
+  Editor editor;
+  try {
+    if (editor.loadCircuit(filePath)) {
+      proc = editor.toCircuit();
+    }
+  } catch (const std::exception &e) {
+    std::cerr << "Error building circuit: " << e.what() << std::endl;
+  }
+  std::cout.rdbuf(out);
+  return proc;
+}
+
+bool OfflineRender::readAudio(const string &filePath, vector<float> &samples,
+                              int &sampleRate) {
+  SF_INFO sfinfo = {};
+  SNDFILE *file = sf_open(filePath.c_str(), SFM_READ, &sfinfo);
+  if (!file) {
+    std::cerr << "Failed to open " << filePath << ": " << sf_strerror(nullptr)
+              << std::endl;
+    return false;
+  }
+  vector<float> interleaved(sfinfo.frames * sfinfo.channels);
+  sf_count_t frames = sf_readf_float(file, interleaved.data(), sfinfo.frames);
+  sf_close(file);
+
+  samples.assign(frames, 0.0f);
+  for (sf_count_t i = 0; i < frames; ++i) {
+    for (int channel = 0; channel < sfinfo.channels; ++channel) {
+      samples[i] += interleaved[i * sfinfo.channels + channel];
+    }
+    samples[i] /= sfinfo.channels;
+  }
+  sampleRate = sfinfo.samplerate;
+  return true;
+}
+
+bool OfflineRender::writeAudio(const string &filePath,
+                               const vector<float> &samples, int sampleRate) {
+  SF_INFO sfinfo = {};
+  sfinfo.samplerate = sampleRate;
+  sfinfo.channels = 1;
+  sfinfo.format = SF_FORMAT_WAV | SF_FORMAT_FLOAT;
+  SNDFILE *file = sf_open(filePath.c_str(), SFM_WRITE, &sfinfo);
+  if (!file) {
+    std::cerr << "Failed to open " << filePath << " for writing: "
+              << sf_strerror(nullptr) << std::endl;
+    return false;
+  }
+  sf_writef_float(file, samples.data(), samples.size());
+  sf_close(file);
+  return true;
+}
+
+double OfflineRender::render(Processor *processor, const vector<float> &input,
+                             vector<float> &output, float sampleRate,
+                             size_t blockSize) {
+  processor->prepare(sampleRate, 2, blockSize);
+  output.assign(input.size(), 0.0f);
+  vector<float> left(blockSize), right(blockSize);
+  vector<float> outLeft(blockSize), outRight(blockSize);
+  float *in[2] = {left.data(), right.data()};
+  float *out[2] = {outLeft.data(), outRight.data()};
+
+  double elapsed = 0.0;
+  for (size_t offset = 0; offset < input.size(); offset += blockSize) {
+    size_t n = std::min(blockSize, input.size() - offset);
+    std::copy(input.begin() + offset, input.begin() + offset + n, left.begin());
+    std::copy(input.begin() + offset, input.begin() + offset + n,
+              right.begin());
+    auto start = std::chrono::steady_clock::now();
+    {
+      Trace::Span span("process", typeid(*processor));
+      processor->process(in, out, n);
+    }
+    auto end = std::chrono::steady_clock::now();
+    elapsed += std::chrono::duration<double>(end - start).count();
+    std::copy(outLeft.begin(), outLeft.begin() + n, output.begin() + offset);
+  }
+  return elapsed;
+}
+
+nlohmann::json OfflineRender::solverReport(const SolverSnapshot &stats) {
+  vector<uint64_t> histogram(stats.iterations,
+                             stats.iterations + SolverSnapshot::NUM_BINS);
+  return {{"samples", stats.samples},
+          {"meanIterations", stats.meanIterations()},
+          {"iterationHistogram", histogram},
+          {"nonConverged", stats.nonConverged},
+          {"maxResidual", stats.maxResidual},
+          {"factorizationsPerBuffer",
+           stats.buffers ? (double)stats.factorizations / stats.buffers : 0.0},
+          {"maxFactorizationsPerBuffer", stats.maxFactorizationsPerBuffer},
+          {"degradedSamples", stats.degradedSamples},
+          {"worstSampleNs", stats.worstSampleNs}};
+}
+
+nlohmann::json OfflineRender::perfReport(const PerfCounters &counters) {
+  string error = counters.getError();
+  if (!error.empty()) {
+    return {{"error", error}};
+  }
+  nlohmann::json report = nlohmann::json::object();
+  for (int p = 0; p < NUM_PERF_PHASES; ++p) {
+    PerfCounts c = counters.read((PerfPhase)p);
+    double calls = std::max<uint64_t>(c.calls, 1);
+    report[PerfCounters::phaseName((PerfPhase)p)] = {
+        {"calls", c.calls},
+        {"cyclesPerCall", c.cycles / calls},
+        {"instructionsPerCall", c.instructions / calls},
+        {"ipc", c.cycles ? (double)c.instructions / c.cycles : 0.0},
+        {"cacheMissesPerCall", c.cacheMisses / calls},
+        {"branchMissesPerCall", c.branchMisses / calls}};
+  }
+  return report;
+}
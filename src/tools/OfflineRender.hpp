@@ -0,0 +1,29 @@
+#pragma once
+
+#include "../audio/processors/CircuitProcessor.hpp"
+#include <nlohmann/json.hpp>
+#include <string>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+// Helpers shared by the headless tools: no window, no audio device.
+class OfflineRender {
+public:
+  // Builds a circuit saved by the editor through the same netlist path as
+  // Editor::toCircuit. Returns nullptr on failure.
+  static CircuitProcessor *loadCircuit(const string &filePath);
+  // Reads any libsndfile format, mixed down to mono.
+  static bool readAudio(const string &filePath, vector<float> &samples,
+                        int &sampleRate);
+  static bool writeAudio(const string &filePath, const vector<float> &samples,
+                         int sampleRate);
+  // Streams input through the processor block by block, returns the wall
+  // clock time spent in process() in seconds.
+  static double render(Processor *processor, const vector<float> &input,
+                       vector<float> &output, float sampleRate,
+                       size_t blockSize = 512);
+  static nlohmann::json solverReport(const SolverSnapshot &stats);
+  static nlohmann::json perfReport(const PerfCounters &counters);
+};
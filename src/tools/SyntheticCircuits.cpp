@@ -0,0 +1,103 @@
+#include "SyntheticCircuits.hpp"
+#include "../circuits/models/CapacitorModel.hpp"
+#include "../circuits/models/DiodeModel.hpp"
+#include "../circuits/models/ResistorModel.hpp"
+#include "../circuits/models/VoltageSourceModel.hpp"
+#include "../circuits/models/transistors/BJTs/NPNModel.hpp"
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+static CircuitProcessor *finish(Circuit *c, int inputIndex, int outputNode) {
+  c->initializeState();
+  CircuitProcessor *cp = new CircuitProcessor(c);
+  cp->setInput(inputIndex);
+  cp->setOutput(outputNode);
+  return cp;
+}
+
+CircuitProcessor *SyntheticCircuits::RCLadder(int nodes) {
+  nodes = std::max(nodes, 2);
+  int gnd = -1;
+  Circuit *c = new Circuit(nodes);
+  int inputIndex = c->addComponent(new VoltageSourceModel(0.0, 0, gnd));
+  for (int i = 1; i < nodes; ++i) {
+    c->addComponent(new ResistorModel(1e3, i - 1, i));
+    c->addComponent(new CapacitorModel(10e-9, i, gnd));
+  }
+  return finish(c, inputIndex, nodes - 1);
+}
+
+CircuitProcessor *SyntheticCircuits::DiodeLadder(int nodes) {
+  nodes = std::max(nodes, 2);
+  int gnd = -1;
+  Circuit *c = new Circuit(nodes);
+  int inputIndex = c->addComponent(new VoltageSourceModel(0.0, 0, gnd));
+  for (int i = 1; i < nodes; ++i) {
+    c->addComponent(new ResistorModel(1e3, i - 1, i));
+    c->addComponent(new DiodeModel(i, gnd, "1N4148"));
+    c->addComponent(new DiodeModel(gnd, i, "1N4148"));
+    c->addComponent(new CapacitorModel(1e-9, i, gnd));
+  }
+  return finish(c, inputIndex, nodes - 1);
+}
+
+CircuitProcessor *SyntheticCircuits::CommonEmitterCascade(int nodes) {
+  // Input and rail, then base, collector and emitter for each stage
+  int stages = std::max((nodes - 2) / 3, 1);
+  int gnd = -1;
+  int nodeIn = 0;
+  int rail = 1;
+  Circuit *c = new Circuit(2 + 3 * stages);
+  int inputIndex = c->addComponent(new VoltageSourceModel(0.0, nodeIn, gnd));
+  c->addComponent(new VoltageSourceModel(9.0, rail, gnd));
+  int previous = nodeIn;
+  for (int s = 0; s < stages; ++s) {
+    int b = 2 + 3 * s;
+    int col = b + 1;
+    int e = b + 2;
+    c->addComponent(new CapacitorModel(0.1e-6, previous, b));
+    c->addComponent(new ResistorModel(100e3, rail, b));
+    c->addComponent(new ResistorModel(22e3, b, gnd));
+    c->addComponent(new ResistorModel(4.7e3, rail, col));
+    c->addComponent(new ResistorModel(1e3, e, gnd));
+    c->addComponent(new NPNModel(b, col, e, "2N3904"));
+    previous = col;
+  }
+  return finish(c, inputIndex, previous);
+}
+
+CircuitProcessor *SyntheticCircuits::RandomMesh(int nodes, unsigned seed) {
+  nodes = std::max(nodes, 2);
+  int gnd = -1;
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<double> decade(2.0, 5.0);
+  std::uniform_int_distribution<int> kind(0, 9);
+  Circuit *c = new Circuit(nodes);
+  int inputIndex = c->addComponent(new VoltageSourceModel(0.0, 0, gnd));
+
+  // A random spanning tree keeps the mesh connected, every node leaks to
+  // ground so that the DC problem stays well posed.
+  for (int i = 1; i < nodes; ++i) {
+    int j = std::uniform_int_distribution<int>(0, i - 1)(rng);
+    c->addComponent(new ResistorModel(pow(10.0, decade(rng)), j, i));
+    c->addComponent(new ResistorModel(1e6, i, gnd));
+  }
+  std::uniform_int_distribution<int> node(0, nodes - 1);
+  for (int k = 0; k < nodes; ++k) {
+    int a = node(rng);
+    int b = node(rng);
+    if (a == b) {
+      continue;
+    }
+    int type = kind(rng);
+    if (type < 6) {
+      c->addComponent(new ResistorModel(pow(10.0, decade(rng)), a, b));
+    } else if (type < 9) {
+      c->addComponent(new CapacitorModel(pow(10.0, -decade(rng) - 4), a, b));
+    } else {
+      c->addComponent(new DiodeModel(a, b, "1N4148"));
+    }
+  }
+  return finish(c, inputIndex, nodes - 1);
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include "../audio/processors/CircuitProcessor.hpp"
+
+// Parametric circuits of roughly `nodes` nodes, used to see how the solvers
+// scale. Node 0 is always driven by the input source.
+class SyntheticCircuits {
+public:
+  static CircuitProcessor *RCLadder(int nodes);
+  static CircuitProcessor *DiodeLadder(int nodes);
+  static CircuitProcessor *CommonEmitterCascade(int nodes);
+  static CircuitProcessor *RandomMesh(int nodes, unsigned seed = 1);
+};
@@ -0,0 +1,206 @@
+#include "../audio/processors/customs/PedalProcessors.hpp"
+#include "../circuits/models/DiodeModel.hpp"
+#include "../circuits/models/VoltageSourceModel.hpp"
+#include "../circuits/models/transistors/BJTs/NPNModel.hpp"
+#include "OfflineRender.hpp"
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+using Clock = std::chrono::steady_clock;
+
+static double nsSince(Clock::time_point start) {
+  return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+}
+
+static vector<float> makeStimulus(size_t numSamples, float sampleRate) {
+  vector<float> samples(numSamples);
+  for (size_t i = 0; i < numSamples; ++i) {
+    samples[i] = 0.3f * sinf(2.0f * M_PI * 220.0f * i / sampleRate);
+  }
+  return samples;
+}
+
+// Same loop as Circuit::solveTransient, timing each phase on its own
+static json breakdown(Circuit *circuit, int inputIndex,
+                      const vector<float> &input, float sampleRate) {
+  auto *v = dynamic_cast<VoltageSourceModel *>(
+      circuit->getComponents()[inputIndex]);
+  int n = circuit->getLastIndex();
+  Eigen::MatrixXd G(n, n);
+  Eigen::VectorXd I(n);
+  double dt = 1.0 / sampleRate;
+  double stampNs = 0, factorizeNs = 0, solveNs = 0, updateNs = 0;
+  size_t iterations = 0;
+
+  for (size_t i = 0; i < input.size(); ++i) {
+    Eigen::VectorXd V_prev;
+    bool converged = false;
+    for (int iter = 0; iter < 10 && !converged; iter++) {
+      iterations++;
+      auto start = Clock::now();
+      G.setZero();
+      I.setZero();
+      v->setVoltage(input[i]);
+      circuit->stamp(G, I, i * dt, dt);
+      stampNs += nsSince(start);
+
+      start = Clock::now();
+      Eigen::FullPivLU<Eigen::MatrixXd> lu(G);
+      factorizeNs += nsSince(start);
+
+      start = Clock::now();
+      Eigen::VectorXd V_next = lu.solve(I);
+      solveNs += nsSince(start);
+
+      if (iter > 0) {
+        converged = (V_next - V_prev).norm() / V_next.norm() < 1e-5;
+      }
+      V_prev = V_next;
+
+      start = Clock::now();
+      circuit->updateState(V_next);
+      updateNs += nsSince(start);
+    }
+  }
+
+  return {{"unknowns", n},
+          {"iterationsPerSample", (double)iterations / input.size()},
+          {"stampNsPerIteration", stampNs / iterations},
+          {"factorizeNsPerIteration", factorizeNs / iterations},
+          {"solveNsPerIteration", solveNs / iterations},
+          {"updateStateNsPerIteration", updateNs / iterations}};
+}
+
+static json benchCircuit(const string &name, CircuitProcessor *proc,
+                         const vector<float> &input, float sampleRate,
+                         bool perf) {
+  Circuit *circuit = proc->getCircuit();
+  circuit->initializeState();
+  circuit->setPerfCounters(perf);
+  vector<float> output;
+  size_t before = circuit->getIterationCount();
+  double seconds = OfflineRender::render(proc, input, output, sampleRate);
+  size_t iterations = circuit->getIterationCount() - before;
+  double ns = seconds * 1e9 / input.size();
+  json solver = OfflineRender::solverReport(circuit->getStats().read());
+  circuit->setPerfCounters(false);
+
+  circuit->initializeState();
+  json result = {{"name", name},
+                 {"samples", input.size()},
+                 {"nsPerSample", ns},
+                 {"iterationsPerSample", (double)iterations / input.size()},
+                 {"realTimeFactor", 1e9 / (ns * sampleRate)},
+                 {"solver", solver}};
+  if (perf) {
+    circuit->getPerfCounters()->publish();
+    result["perf"] = OfflineRender::perfReport(*circuit->getPerfCounters());
+  }
+  result["breakdown"] =
+      breakdown(circuit, proc->getInput(), input, sampleRate);
+  return result;
+}
+
+static json benchDevice(const string &name, ComponentModel *model, int nodes,
+                        size_t calls) {
+  Eigen::VectorXd V = Eigen::VectorXd::Zero(nodes);
+  Eigen::VectorXd I = Eigen::VectorXd::Zero(nodes);
+  auto start = Clock::now();
+  for (size_t i = 0; i < calls; ++i) {
+    // Sweep the terminals through cut-off and conduction
+    double x = -1.0 + 1.8 * (double)(i % 1024) / 1024.0;
+    V(0) = x;
+    if (nodes > 1) {
+      V(1) = 2.0 * x + 1.0;
+    }
+    model->updateState(V, I);
+  }
+  double ns = nsSince(start);
+  return {{"name", name}, {"calls", calls}, {"nsPerCall", ns / calls}};
+}
+
+static void usage(const char *name) {
+  std::cerr << "Usage: " << name << " [options]\n"
+            << "Options:\n"
+            << "  --seconds S      Audio rendered per circuit (default 1)\n"
+            << "  --amplifier F    Circuit JSON (default "
+               "../assets/amplifier.json)\n"
+            << "  --perf           Count cycles, instructions, cache and branch "
+               "misses\n"
+            << "                   of the solver phases (the timings are then "
+               "off)\n"
+            << "  --output F       Write the JSON report to F instead of "
+               "stdout\n";
+}
+
+int main(int argc, char *argv[]) {
+  double seconds = 1.0;
+  string amplifierPath = "../assets/amplifier.json";
+  string outputPath;
+  bool perf = false;
+  for (int i = 1; i < argc; ++i) {
+    string arg = argv[i];
+    bool hasValue = i + 1 < argc;
+    if (arg == "--seconds" && hasValue) {
+      seconds = std::stod(argv[++i]);
+    } else if (arg == "--amplifier" && hasValue) {
+      amplifierPath = argv[++i];
+    } else if (arg == "--perf") {
+      perf = true;
+    } else if (arg == "--output" && hasValue) {
+      outputPath = argv[++i];
+    } else {
+      usage(argv[0]);
+      return 1;
+    }
+  }
+
+  const float sampleRate = 44100.0f;
+  vector<float> input = makeStimulus(seconds * sampleRate, sampleRate);
+
+  json report;
+  report["sampleRate"] = sampleRate;
+  report["circuits"] = json::array();
+
+  CircuitProcessor *fuzz = PedalProcessors::FuzzProcessor();
+  report["circuits"].push_back(
+      benchCircuit("fuzz", fuzz, input, sampleRate, perf));
+  delete fuzz;
+
+  CircuitProcessor *lowPass = PedalProcessors::LowPassProcessor(1e3, 100e-9);
+  report["circuits"].push_back(
+      benchCircuit("lowpass", lowPass, input, sampleRate, perf));
+  delete lowPass;
+
+  CircuitProcessor *amplifier = OfflineRender::loadCircuit(amplifierPath);
+  if (amplifier) {
+    report["circuits"].push_back(
+        benchCircuit("amplifier", amplifier, input, sampleRate, perf));
+    delete amplifier;
+  } else {
+    std::cerr << "Skipping " << amplifierPath << std::endl;
+  }
+
+  const size_t calls = 1000000;
+  DiodeModel diode(0, -1, "1N4148");
+  NPNModel npn(0, 1, -1, "2N3904");
+  report["devices"] = {
+      benchDevice("DiodeModel::updateState", &diode, 1, calls),
+      benchDevice("NPNModel::updateState", &npn, 2, calls)};
+
+  if (outputPath.empty()) {
+    std::cout << report.dump(2) << std::endl;
+  } else {
+    std::ofstream file(outputPath);
+    if (!file.is_open()) {
+      std::cerr << "Failed to open " << outputPath << std::endl;
+      return 1;
+    }
+    file << report.dump(2) << std::endl;
+  }
+  return 0;
+}
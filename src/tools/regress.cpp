@@ -0,0 +1,562 @@
+#include "../audio/engine/AudioEngine.hpp"
+#include "../audio/engine/Kernels.hpp"
+#include "../audio/engine/NullAudioBackend.hpp"
+#include "../audio/engine/WorkerPool.hpp"
+#include "../audio/processors/AddProcessor.hpp"
+#include "../audio/processors/customs/PedalProcessors.hpp"
+#include "OfflineRender.hpp"
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <nlohmann/json.hpp>
+#include <random>
+
+using json = nlohmann::json;
+namespace fs = std::filesystem;
+
+struct Stimulus {
+  string name;
+  vector<float> samples;
+  double fundamental; // Hz, 0 when THD is meaningless for this signal
+};
+
+struct CircuitCase {
+  string name;
+  std::function<CircuitProcessor *()> make;
+};
+
+struct Thresholds {
+  double minSnr = 60.0;          // dB
+  double maxError = 1e-3;        // Absolute, in volts
+  double maxThdDelta = 0.005;    // Absolute THD ratio
+  double maxSlowdown = 0.25;     // Relative ns/sample increase over baseline
+  double maxLevel = 50.0;        // Volts, no golden should go past this
+  double minMultirateSnr = 20.0; // dB, decimated supply against full rate
+  double maxMultirateLoss = 1.0; // dB under the undecimated split's SNR
+  // dB. Both SNRs are capped here before the loss is taken: past it the
+  // renders differ by float rounding, not by decimating.
+  double multirateSnrCeiling = 120.0;
+};
+
+static Stimulus sine(float sampleRate) {
+  Stimulus s = {"sine", vector<float>(sampleRate / 2), 1000.0};
+  for (size_t i = 0; i < s.samples.size(); ++i) {
+    s.samples[i] = 0.5f * sinf(2.0f * M_PI * s.fundamental * i / sampleRate);
+  }
+  return s;
+}
+
+// Exponential sweep from 20 Hz to 20 kHz over one second
+static Stimulus sweep(float sampleRate) {
+  Stimulus s = {"sweep", vector<float>(sampleRate), 0.0};
+  const double f0 = 20.0, f1 = 20000.0, duration = 1.0;
+  const double k = std::log(f1 / f0);
+  for (size_t i = 0; i < s.samples.size(); ++i) {
+    double t = i / sampleRate;
+    double phase = 2.0 * M_PI * f0 * duration / k *
+                   (std::exp(t / duration * k) - 1.0);
+    s.samples[i] = 0.5f * std::sin(phase);
+  }
+  return s;
+}
+
+static Stimulus impulse(float sampleRate) {
+  Stimulus s = {"impulse", vector<float>(sampleRate / 4, 0.0f), 0.0};
+  s.samples[0] = 0.5f;
+  return s;
+}
+
+// Karplus-Strong string, a stand-in for a guitar DI when no clip is given.
+// The noise burst comes straight from mt19937, which is specified bit for
+// bit, so the stimulus is the same on every platform.
+static Stimulus pluck(float sampleRate) {
+  Stimulus s = {"pluck", vector<float>(sampleRate), 0.0};
+  std::mt19937 rng(1);
+  vector<float> delay(sampleRate / 110.0f);
+  for (auto &x : delay) {
+    x = 0.25f * ((float)rng() / (float)std::mt19937::max() * 2.0f - 1.0f);
+  }
+  for (size_t i = 0; i < s.samples.size(); ++i) {
+    size_t k = i % delay.size();
+    float next = delay[(k + 1) % delay.size()];
+    s.samples[i] = delay[k];
+    delay[k] = 0.996f * 0.5f * (delay[k] + next);
+  }
+  return s;
+}
+
+// Adds within adds whose branches always go to the pool, so that runs start
+// from within pool jobs, on workers and the calling thread at once
+static Processor *nestedAdds(double parallelMinSeconds) {
+  auto add = [parallelMinSeconds](Processor *a, Processor *b) {
+    AddProcessor *p = new AddProcessor(a, b);
+    p->setParallelMinSeconds(parallelMinSeconds);
+    return p;
+  };
+  return add(add(PedalProcessors::FuzzProcessor(),
+                 PedalProcessors::LowPassProcessor(1e3, 100e-9)),
+             add(PedalProcessors::LowPassProcessor(2e3, 100e-9),
+                 PedalProcessors::FuzzProcessor()));
+}
+
+static double snr(const vector<float> &reference, const vector<float> &output) {
+  double signal = 0.0, noise = 0.0;
+  for (size_t i = 0; i < reference.size(); ++i) {
+    double e = output[i] - reference[i];
+    signal += reference[i] * reference[i];
+    noise += e * e;
+  }
+  if (noise == 0.0) {
+    return INFINITY;
+  }
+  return 10.0 * std::log10(signal / noise);
+}
+
+static double maxAbsError(const vector<float> &reference,
+                          const vector<float> &output) {
+  double error = 0.0;
+  for (size_t i = 0; i < reference.size(); ++i) {
+    error = std::max(error, (double)std::abs(output[i] - reference[i]));
+  }
+  return error;
+}
+
+static double goertzelPower(const vector<float> &x, size_t start,
+                            double frequency, float sampleRate) {
+  double w = 2.0 * M_PI * frequency / sampleRate;
+  double coeff = 2.0 * std::cos(w);
+  double s1 = 0.0, s2 = 0.0;
+  for (size_t i = start; i < x.size(); ++i) {
+    double s0 = x[i] + coeff * s1 - s2;
+    s2 = s1;
+    s1 = s0;
+  }
+  return s1 * s1 + s2 * s2 - coeff * s1 * s2;
+}
+
+// Ratio of the harmonics' amplitude to the fundamental's, on the second half
+// of the signal so that the start-up transient is left out.
+static double thd(const vector<float> &x, double fundamental,
+                  float sampleRate) {
+  size_t start = x.size() / 2;
+  double base = goertzelPower(x, start, fundamental, sampleRate);
+  if (base <= 0.0) {
+    return 0.0;
+  }
+  double harmonics = 0.0;
+  for (int h = 2; h * fundamental < sampleRate / 2 && h <= 10; ++h) {
+    harmonics += goertzelPower(x, start, h * fundamental, sampleRate);
+  }
+  return std::sqrt(harmonics / base);
+}
+
+static void usage(const char *name) {
+  std::cerr
+      << "Usage: " << name << " [options]\n"
+      << "Renders fixed stimuli through the built-in pedals and the given "
+         "circuits and compares\nthe output with the golden files.\n"
+      << "Options:\n"
+      << "  --golden D         Golden directory (default ../assets/golden)\n"
+      << "  --update           Write the current output as the new golden\n"
+      << "  --update-baseline  Only record this machine's ns/sample "
+         "(baseline.json), if every case passes\n"
+      << "  --circuit F        Also check a circuit JSON (repeatable, default "
+         "../assets/amplifier.json)\n"
+      << "  --stimulus F       Also use an audio clip as stimulus "
+         "(repeatable)\n"
+      << "  --min-snr DB       Fail under this SNR (default 60)\n"
+      << "  --max-error V      Fail over this max abs error (default 1e-3)\n"
+      << "  --min-slow-snr DB  Fail the decimated fuzz supply under this SNR "
+         "(default 20)\n"
+      << "  --max-slow-loss DB Also fail when it is more than this under the "
+         "undecimated\n"
+      << "                     split's SNR (default 1)\n"
+      << "  --max-thd-delta X  Fail over this THD change (default 0.005)\n"
+      << "  --max-slowdown X   Fail when ns/sample grows by more than this "
+         "ratio (default 0.25)\n"
+      << "  --max-level V      Refuse to write goldens peaking over this "
+         "(default 50)\n"
+      << "  --no-timing        Do not check ns/sample\n"
+      << "  --output F         Write the JSON report to F\n";
+}
+
+int main(int argc, char *argv[]) {
+  string goldenDir = "../assets/golden";
+  string outputPath;
+  vector<string> circuitPaths;
+  vector<string> stimulusPaths;
+  bool update = false;
+  bool updateBaseline = false;
+  bool timing = true;
+  Thresholds limits;
+  for (int i = 1; i < argc; ++i) {
+    string arg = argv[i];
+    bool hasValue = i + 1 < argc;
+    if (arg == "--golden" && hasValue) {
+      goldenDir = argv[++i];
+    } else if (arg == "--update") {
+      update = true;
+    } else if (arg == "--update-baseline") {
+      updateBaseline = true;
+    } else if (arg == "--circuit" && hasValue) {
+      circuitPaths.emplace_back(argv[++i]);
+    } else if (arg == "--stimulus" && hasValue) {
+      stimulusPaths.emplace_back(argv[++i]);
+    } else if (arg == "--min-snr" && hasValue) {
+      limits.minSnr = std::stod(argv[++i]);
+    } else if (arg == "--max-error" && hasValue) {
+      limits.maxError = std::stod(argv[++i]);
+    } else if (arg == "--min-slow-snr" && hasValue) {
+      limits.minMultirateSnr = std::stod(argv[++i]);
+    } else if (arg == "--max-slow-loss" && hasValue) {
+      limits.maxMultirateLoss = std::stod(argv[++i]);
+    } else if (arg == "--max-thd-delta" && hasValue) {
+      limits.maxThdDelta = std::stod(argv[++i]);
+    } else if (arg == "--max-slowdown" && hasValue) {
+      limits.maxSlowdown = std::stod(argv[++i]);
+    } else if (arg == "--max-level" && hasValue) {
+      limits.maxLevel = std::stod(argv[++i]);
+    } else if (arg == "--no-timing") {
+      timing = false;
+    } else if (arg == "--output" && hasValue) {
+      outputPath = argv[++i];
+    } else {
+      usage(argv[0]);
+      return 1;
+    }
+  }
+  if (circuitPaths.empty()) {
+    circuitPaths.emplace_back("../assets/amplifier.json");
+  }
+
+  const float sampleRate = 44100.0f;
+  vector<Stimulus> stimuli = {sine(sampleRate), sweep(sampleRate),
+                              impulse(sampleRate), pluck(sampleRate)};
+  for (const auto &path : stimulusPaths) {
+    Stimulus s = {fs::path(path).stem().string(), {}, 0.0};
+    int rate;
+    if (!OfflineRender::readAudio(path, s.samples, rate)) {
+      return 1;
+    }
+    if (rate != (int)sampleRate) {
+      std::cerr << path << " is not at " << sampleRate << " Hz" << std::endl;
+      return 1;
+    }
+    stimuli.emplace_back(s);
+  }
+
+  vector<CircuitCase> circuits = {
+      {"fuzz", []() { return PedalProcessors::FuzzProcessor(); }},
+      {"lowpass",
+       []() { return PedalProcessors::LowPassProcessor(1e3, 100e-9); }},
+  };
+  for (const auto &path : circuitPaths) {
+    circuits.push_back({fs::path(path).stem().string(),
+                        [path]() { return OfflineRender::loadCircuit(path); }});
+  }
+
+  fs::create_directories(goldenDir);
+  fs::path baselinePath = fs::path(goldenDir) / "baseline.json";
+  json baseline = json::object();
+  if (fs::exists(baselinePath)) {
+    std::ifstream file(baselinePath);
+    file >> baseline;
+  }
+
+  json report;
+  report["sampleRate"] = sampleRate;
+  report["cases"] = json::array();
+  int failures = 0;
+
+  for (const auto &circuit : circuits) {
+    for (const auto &stimulus : stimuli) {
+      string name = circuit.name + "_" + stimulus.name;
+      CircuitProcessor *proc = circuit.make();
+      if (!proc) {
+        std::cerr << "Failed to build " << circuit.name << std::endl;
+        failures++;
+        continue;
+      }
+      proc->getCircuit()->initializeState();
+      vector<float> output;
+      double seconds;
+      try {
+        seconds =
+            OfflineRender::render(proc, stimulus.samples, output, sampleRate);
+      } catch (const std::exception &e) {
+        std::cerr << name << ": " << e.what() << std::endl;
+        delete proc;
+        failures++;
+        continue;
+      }
+      json result = {
+          {"name", name},
+          {"solver",
+           OfflineRender::solverReport(proc->getCircuit()->getStats().read())}};
+      delete proc;
+      double ns = seconds * 1e9 / stimulus.samples.size();
+      string goldenPath = (fs::path(goldenDir) / (name + ".wav")).string();
+      result["nsPerSample"] = ns;
+      bool finite = std::all_of(output.begin(), output.end(),
+                                [](float x) { return std::isfinite(x); });
+      if (!finite) {
+        std::cerr << name << ": solver output is not finite" << std::endl;
+        failures++;
+        continue;
+      }
+      if (update) {
+        float peak = 0.0f;
+        for (float x : output) {
+          peak = std::max(peak, std::abs(x));
+        }
+        if (peak > limits.maxLevel) {
+          std::cerr << name << ": output reaches " << peak
+                    << " V, not writing it as a golden" << std::endl;
+          failures++;
+          continue;
+        }
+        if (!OfflineRender::writeAudio(goldenPath, output, sampleRate)) {
+          return 1;
+        }
+        baseline[name] = {{"nsPerSample", ns}};
+        report["cases"].push_back(result);
+        std::cout << std::left << std::setw(24) << name << " updated"
+                  << std::endl;
+        continue;
+      }
+
+      vector<float> golden;
+      int rate;
+      if (!fs::exists(goldenPath) ||
+          !OfflineRender::readAudio(goldenPath, golden, rate) ||
+          golden.size() != output.size()) {
+        std::cerr << name << ": no usable golden at " << goldenPath
+                  << ", run with --update" << std::endl;
+        failures++;
+        continue;
+      }
+
+      vector<string> failed;
+      double s = snr(golden, output);
+      double error = maxAbsError(golden, output);
+      result["snrDb"] = std::isinf(s) ? json(nullptr) : json(s);
+      result["maxAbsError"] = error;
+      if (s < limits.minSnr) {
+        failed.emplace_back("snr");
+      }
+      if (error > limits.maxError) {
+        failed.emplace_back("error");
+      }
+      if (stimulus.fundamental > 0.0) {
+        double delta = std::abs(thd(output, stimulus.fundamental, sampleRate) -
+                                thd(golden, stimulus.fundamental, sampleRate));
+        result["thdDelta"] = delta;
+        if (delta > limits.maxThdDelta) {
+          failed.emplace_back("thd");
+        }
+      }
+      if (updateBaseline) {
+        baseline[name] = {{"nsPerSample", ns}};
+      } else if (baseline.contains(name)) {
+        double reference = baseline[name]["nsPerSample"];
+        result["baselineNsPerSample"] = reference;
+        if (timing && ns > reference * (1.0 + limits.maxSlowdown)) {
+          failed.emplace_back("speed");
+        }
+      }
+      result["failed"] = failed;
+      report["cases"].push_back(result);
+
+      std::cout << std::left << std::setw(24) << name << std::right
+                << " snr " << std::setw(8) << std::setprecision(4) << s
+                << " dB  err " << std::setw(10) << error << "  "
+                << std::setw(10) << ns << " ns/sample";
+      if (failed.empty()) {
+        std::cout << "  ok" << std::endl;
+      } else {
+        failures++;
+        std::cout << "  FAILED";
+        for (const auto &f : failed) {
+          std::cout << " " << f;
+        }
+        std::cout << std::endl;
+      }
+    }
+  }
+
+  {
+    // Parallel branches must give the serial result to the bit, and return
+    WorkerPool::instance().setThreads(3);
+    vector<float> serial, parallel;
+    Processor *reference = nestedAdds(INFINITY);
+    Processor *nested = nestedAdds(0.0);
+    OfflineRender::render(reference, stimuli[0].samples, serial, sampleRate);
+    OfflineRender::render(nested, stimuli[0].samples, parallel, sampleRate);
+    delete reference;
+    delete nested;
+    WorkerPool::instance().setThreads(0);
+    bool same = serial == parallel;
+    report["nestedParallel"] = same;
+    std::cout << std::left << std::setw(24) << "nested_parallel"
+              << (same ? " ok" : " FAILED") << std::endl;
+    if (!same) {
+      failures++;
+    }
+  }
+
+  // Every kernel set the CPU has must match the plain one to the bit,
+  // whichever one LOGIISOUND_KERNELS picked for the renders above
+  {
+    string difference = Kernels::check();
+    report["kernels"] = {{"set", Kernels::getName()},
+                         {"difference", difference},
+                         {"ok", difference.empty()}};
+    std::cout << std::left << std::setw(24) << "kernels"
+              << (difference.empty() ? " ok" : " FAILED: " + difference)
+              << std::endl;
+    if (!difference.empty()) {
+      failures++;
+    }
+  }
+
+  // The engine cutting host buffers into blocks must play what the fuzz
+  // renders block by block on its own, delayed by the latency it reports:
+  // none when the blocks divide the host buffers, one block otherwise
+  report["blocks"] = json::array();
+  for (unsigned long hostFrames : {128ul, 100ul}) {
+    const unsigned long blockSize = 64;
+    // Whole host buffers, as a short last one would start the delay
+    vector<float> input = stimuli[0].samples;
+    input.resize(input.size() / hostFrames * hostFrames);
+    string name = "fuzz_" + stimuli[0].name + "_blocks_" +
+                  std::to_string(hostFrames);
+    CircuitProcessor *direct = PedalProcessors::FuzzProcessor();
+    CircuitProcessor *blocked = PedalProcessors::FuzzProcessor();
+    vector<float> reference, played;
+    unsigned long latency = 0;
+    try {
+      OfflineRender::render(direct, input, reference, sampleRate, blockSize);
+      // As the engine plays it
+      Kernels::clip(reference.data(), reference.data(), -1.0f, 1.0f,
+                    reference.size());
+      NullAudioBackend *device = new NullAudioBackend(NullPacing::Freewheel);
+      device->setInput(input);
+      device->setRecordOutput(true);
+      AudioEngine engine(blocked, device);
+      AudioConfig config;
+      config.sampleRate = sampleRate;
+      config.framesPerBuffer = hostFrames;
+      config.blockSize = blockSize;
+      engine.setConfig(config);
+      engine.start();
+      device->wait();
+      latency = engine.getBlockLatency();
+      engine.stop();
+      played = device->getRecordedOutput();
+    } catch (const std::exception &e) {
+      std::cerr << name << ": " << e.what() << std::endl;
+      played.clear();
+    }
+    delete direct;
+    delete blocked;
+
+    unsigned long expectedLatency = hostFrames % blockSize ? blockSize : 0;
+    // Samples past the last whole block never reach the output
+    size_t compared = played.size() > latency ? played.size() - latency : 0;
+    bool ok = played.size() == input.size() && latency == expectedLatency;
+    for (size_t i = 0; ok && i < latency; ++i) {
+      ok = played[i] == 0.0f;
+    }
+    for (size_t i = 0; ok && i < compared; ++i) {
+      ok = played[i + latency] == reference[i];
+    }
+    report["blocks"].push_back({{"name", name},
+                                {"latency", latency},
+                                {"comparedSamples", compared},
+                                {"ok", ok}});
+    std::cout << std::left << std::setw(24) << name << std::right
+              << " latency " << std::setw(4) << latency
+              << (ok ? "  ok" : "  FAILED") << std::endl;
+    if (!ok) {
+      failures++;
+    }
+  }
+
+  // The fuzz with its supply stepped at the decimated rate must stay close
+  // to the same pedal solved at full rate, and decimating may not lose more
+  // than the split alone (decimation 1) already does. The split departs
+  // from the full solve where the pedal switches: Newton's tolerance moves
+  // a switching event by a sample or two, which the sweep turns into about
+  // 25 dB. The floor stays absolute, so a split broken the same way as the
+  // decimated path still fails.
+  report["multirate"] = json::array();
+  for (const auto &stimulus : stimuli) {
+    string name = "fuzz_" + stimulus.name + "_multirate";
+    CircuitProcessor *full = PedalProcessors::FuzzProcessor();
+    CircuitProcessor *split = PedalProcessors::FuzzProcessor(true);
+    CircuitProcessor *multirate = PedalProcessors::FuzzProcessor(true);
+    split->getCircuit()->setSlowDecimation(1);
+    vector<float> reference, undecimated, output;
+    bool rendered = true;
+    try {
+      OfflineRender::render(full, stimulus.samples, reference, sampleRate);
+      OfflineRender::render(split, stimulus.samples, undecimated, sampleRate);
+      OfflineRender::render(multirate, stimulus.samples, output, sampleRate);
+    } catch (const std::exception &e) {
+      std::cerr << name << ": " << e.what() << std::endl;
+      rendered = false;
+    }
+    delete full;
+    delete split;
+    delete multirate;
+    if (!rendered) {
+      failures++;
+      continue;
+    }
+    double s = snr(reference, output);
+    double splitSnr = snr(reference, undecimated);
+    double error = maxAbsError(reference, output);
+    double loss = std::min(splitSnr, limits.multirateSnrCeiling) -
+                  std::min(s, limits.multirateSnrCeiling);
+    bool ok = s >= limits.minMultirateSnr && loss <= limits.maxMultirateLoss;
+    report["multirate"].push_back(
+        {{"name", name},
+         {"snrDb", std::isinf(s) ? json(nullptr) : json(s)},
+         {"splitSnrDb", std::isinf(splitSnr) ? json(nullptr) : json(splitSnr)},
+         {"maxAbsError", error},
+         {"ok", ok}});
+    std::cout << std::left << std::setw(24) << name << std::right << " snr "
+              << std::setw(8) << std::setprecision(4) << s << " dB  split "
+              << std::setw(8) << splitSnr << " dB  err " << std::setw(10)
+              << error << (ok ? "  ok" : "  FAILED") << std::endl;
+    if (!ok) {
+      failures++;
+    }
+  }
+
+  if (updateBaseline && failures > 0) {
+    std::cerr << "Not updating " << baselinePath.string()
+              << ": timings only count for a run that passes" << std::endl;
+  } else if (update || updateBaseline) {
+    std::ofstream file(baselinePath);
+    file << baseline.dump(2) << std::endl;
+  }
+  report["failures"] = failures;
+  if (!outputPath.empty()) {
+    std::ofstream file(outputPath);
+    if (!file.is_open()) {
+      std::cerr << "Failed to open " << outputPath << std::endl;
+      return 1;
+    }
+    file << report.dump(2) << std::endl;
+  }
+  if (failures > 0) {
+    std::cerr << failures << " case(s) failed" << std::endl;
+    return 1;
+  }
+  return 0;
+}
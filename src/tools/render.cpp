@@ -0,0 +1,231 @@
+#include "../audio/engine/AudioEngine.hpp"
+#include "../audio/engine/NullAudioBackend.hpp"
+#include "../audio/engine/WorkerPool.hpp"
+#include "../circuits/solvers/WaveformRelaxationSolver.hpp"
+#include "../core/Trace.hpp"
+#include "OfflineRender.hpp"
+#include <iostream>
+#include <string>
+
+// Runs the circuit through the waveform relaxation solver instead of
+// Circuit::solveTransient.
+class RelaxationProcessor : public Processor {
+  CircuitProcessor *proc;
+  WaveformRelaxationSolver solver;
+  double time = 0.0;
+
+public:
+  RelaxationProcessor(CircuitProcessor *p,
+                      const WaveformRelaxationOptions &options)
+      : Processor(), proc(p), solver(p->getCircuit(), options) {}
+  void render() override {}
+  void process(float **inputBuffer, float **outputBuffer,
+               size_t numSamples) override {
+    solver.solveTransient(time, 1.0 / sampleRate, numSamples, proc->getInput(),
+                          proc->getOutput(), proc->getOutput(), inputBuffer,
+                          outputBuffer);
+    time += (double)numSamples / sampleRate;
+  }
+};
+
+static void printSolverStats(const SolverSnapshot &stats) {
+  std::cout << "Solver: " << stats.meanIterations() << " iterations/sample, "
+            << stats.nonConverged << " of "
+            << stats.samples - stats.degradedSamples
+            << " full-effort samples not converged, max residual "
+            << stats.maxResidual
+            << ", worst sample " << stats.worstSampleNs / 1000.0 << " us"
+            << std::endl;
+  if (stats.degradedBuffers) {
+    std::cout << "Degraded " << stats.degradedSamples << " samples in "
+              << stats.degradedBuffers << " buffers to meet the deadline"
+              << std::endl;
+  }
+}
+
+static void usage(const char *name) {
+  std::cerr
+      << "Usage: " << name << " <circuit.json> <input.wav> <output.wav> [options]\n"
+      << "Options:\n"
+      << "  --block N        Samples per process() call (default 512)\n"
+      << "  --partitions N   Use the waveform relaxation solver with N "
+         "partitions\n"
+      << "  --window N       Relaxation window in samples (default 256)\n"
+      << "  --seidel         Gauss-Seidel sweeps instead of Gauss-Jacobi\n"
+      << "  --decimation N   Solve the components marked slow every N "
+         "samples (default 8)\n"
+      << "  --full-rate      Solve the components marked slow at full rate "
+         "too\n"
+      << "  --paced          Play through the audio engine on a null device "
+         "in real time\n"
+      << "                   and count the buffers that missed their "
+         "deadline\n"
+      << "  --budget F       Let the circuit take F of each buffer's duration "
+         "before it\n"
+      << "                   degrades, e.g. 0.7 (default: never degrade)\n"
+      << "  --trace F        Save a Chrome trace of the run to F\n"
+      << "  --trace-detail   Also trace every solver iteration, keeping only "
+         "the last\n"
+      << "                   fraction of a second\n";
+}
+
+int main(int argc, char *argv[]) {
+  if (argc < 4) {
+    usage(argv[0]);
+    return 1;
+  }
+  string circuitPath = argv[1];
+  string inputPath = argv[2];
+  string outputPath = argv[3];
+  size_t blockSize = 512;
+  int partitions = 0;
+  bool paced = false;
+  float budget = 0.0f;
+  string tracePath;
+  bool traceDetail = false;
+  int decimation = 0;
+  bool fullRate = false;
+  WaveformRelaxationOptions options;
+
+  for (int i = 4; i < argc; ++i) {
+    string arg = argv[i];
+    bool hasValue = i + 1 < argc;
+    if (arg == "--block" && hasValue) {
+      blockSize = std::stoul(argv[++i]);
+    } else if (arg == "--partitions" && hasValue) {
+      partitions = std::stoi(argv[++i]);
+    } else if (arg == "--window" && hasValue) {
+      options.windowSize = std::stoul(argv[++i]);
+    } else if (arg == "--seidel") {
+      options.scheme = RelaxationScheme::GaussSeidel;
+    } else if (arg == "--decimation" && hasValue) {
+      decimation = std::stoi(argv[++i]);
+      if (decimation < 1) {
+        usage(argv[0]);
+        return 1;
+      }
+    } else if (arg == "--full-rate") {
+      fullRate = true;
+    } else if (arg == "--paced") {
+      paced = true;
+    } else if (arg == "--budget" && hasValue) {
+      budget = std::stof(argv[++i]);
+    } else if (arg == "--trace" && hasValue) {
+      tracePath = argv[++i];
+    } else if (arg == "--trace-detail") {
+      traceDetail = true;
+    } else {
+      usage(argv[0]);
+      return 1;
+    }
+  }
+  if (blockSize == 0) {
+    usage(argv[0]);
+    return 1;
+  }
+
+  CircuitProcessor *circuit = OfflineRender::loadCircuit(circuitPath);
+  if (!circuit) {
+    std::cerr << "Failed to load circuit " << circuitPath << std::endl;
+    return 1;
+  }
+  circuit->setBudget(budget);
+  Circuit *solver = circuit->getCircuit();
+  if (fullRate) {
+    for (size_t i = 0; i < solver->getComponents().size(); ++i) {
+      solver->setSlow(i, false);
+    }
+  } else if (decimation > 0) {
+    solver->setSlowDecimation(decimation);
+  }
+  vector<float> input, output;
+  int sampleRate;
+  if (!OfflineRender::readAudio(inputPath, input, sampleRate)) {
+    return 1;
+  }
+
+  if (!tracePath.empty()) {
+    Trace::start(1 << 17, traceDetail);
+    Trace::nameThread("Main");
+  }
+  // Saves the trace, if any, once rendering is over
+  auto saveTrace = [&]() {
+    if (!tracePath.empty() && !Trace::save(tracePath)) {
+      std::cerr << "Failed to write " << tracePath << std::endl;
+      return false;
+    }
+    return true;
+  };
+
+  Processor *processor = circuit;
+  RelaxationProcessor *relaxation = nullptr;
+  if (partitions > 0) {
+    options.partitions = partitions;
+    // Gauss-Jacobi sweeps run the partitions on the pool
+    WorkerPool::instance().setThreads(partitions - 1);
+    relaxation = new RelaxationProcessor(circuit, options);
+    processor = relaxation;
+  }
+
+  if (paced) {
+    NullAudioBackend *device = new NullAudioBackend(NullPacing::RealTime);
+    device->setInput(input);
+    device->setRecordOutput(true);
+    AudioEngine engine(processor, device);
+    try {
+      AudioConfig config;
+      config.sampleRate = sampleRate;
+      config.framesPerBuffer = blockSize;
+      engine.setConfig(config);
+      engine.start();
+      device->wait();
+    } catch (const std::exception &e) {
+      std::cerr << "Error while rendering: " << e.what() << std::endl;
+      return 1;
+    }
+    if (!saveTrace() ||
+        !OfflineRender::writeAudio(outputPath, device->getRecordedOutput(),
+                                   sampleRate)) {
+      return 1;
+    }
+    std::cout << "Played " << device->getStreamTime() << "s of audio in "
+              << device->getBlocksProcessed() << " buffers, "
+              << device->getLateBlocks() << " late" << std::endl;
+    const LoadStats &load = engine.getLoad().read();
+    std::cout << "DSP load " << load.mean << "% avg, " << load.p99
+              << "% p99, " << load.max << "% max of the buffer duration"
+              << std::endl;
+    if (!relaxation) {
+      printSolverStats(circuit->getCircuit()->getStats().read());
+    }
+    engine.stop();
+    delete relaxation;
+    delete circuit;
+    return 0;
+  }
+
+  double elapsed;
+  try {
+    elapsed = OfflineRender::render(processor, input, output, sampleRate,
+                                    blockSize);
+  } catch (const std::exception &e) {
+    std::cerr << "Error while rendering: " << e.what() << std::endl;
+    return 1;
+  }
+  if (!saveTrace() ||
+      !OfflineRender::writeAudio(outputPath, output, sampleRate)) {
+    return 1;
+  }
+
+  double duration = (double)input.size() / sampleRate;
+  std::cout << "Rendered " << duration << "s of audio in " << elapsed
+            << "s (" << duration / elapsed << "x real time, "
+            << elapsed * 1e9 / input.size() << " ns/sample)" << std::endl;
+  if (!relaxation) {
+    printSolverStats(circuit->getCircuit()->getStats().read());
+  }
+
+  delete relaxation;
+  delete circuit;
+  return 0;
+}
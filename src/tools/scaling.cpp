@@ -0,0 +1,203 @@
+#include "../audio/engine/WorkerPool.hpp"
+#include "../circuits/solvers/WaveformRelaxationSolver.hpp"
+#include "SyntheticCircuits.hpp"
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <malloc.h>
+#include <nlohmann/json.hpp>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+
+using std::string;
+
+using json = nlohmann::json;
+using Clock = std::chrono::steady_clock;
+
+static double msSince(Clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(Clock::now() - start)
+      .count();
+}
+
+static long residentBytes() {
+  std::ifstream statm("/proc/self/statm");
+  long size = 0, resident = 0;
+  statm >> size >> resident;
+  return resident * sysconf(_SC_PAGESIZE);
+}
+
+struct Topology {
+  string name;
+  std::function<CircuitProcessor *(int)> make;
+};
+
+// Solves through one of the backends, with the Circuit::solveTransient
+// signature.
+struct Backend {
+  string name;
+  std::function<std::function<void(size_t, float **, float **)>(
+      CircuitProcessor *, float)>
+      make;
+};
+
+static void usage(const char *name) {
+  std::cerr << "Usage: " << name << " [options]\n"
+            << "Options:\n"
+            << "  --sizes A,B,...  Node counts (default "
+               "10,20,50,100,200,500,1000,2000,5000)\n"
+            << "  --samples N      Samples timed per point (default 256)\n"
+            << "  --budget-ms T    Stop growing a curve once one sample "
+               "takes longer (default 50)\n"
+            << "  --output F       Write the JSON report to F instead of "
+               "stdout\n";
+}
+
+int main(int argc, char *argv[]) {
+  vector<int> sizes = {10, 20, 50, 100, 200, 500, 1000, 2000, 5000};
+  size_t samples = 256;
+  double budgetMs = 50.0;
+  string outputPath;
+  for (int i = 1; i < argc; ++i) {
+    string arg = argv[i];
+    bool hasValue = i + 1 < argc;
+    if (arg == "--sizes" && hasValue) {
+      sizes.clear();
+      std::stringstream list(argv[++i]);
+      string item;
+      while (std::getline(list, item, ',')) {
+        sizes.emplace_back(std::stoi(item));
+      }
+    } else if (arg == "--samples" && hasValue) {
+      samples = std::stoul(argv[++i]);
+    } else if (arg == "--budget-ms" && hasValue) {
+      budgetMs = std::stod(argv[++i]);
+    } else if (arg == "--output" && hasValue) {
+      outputPath = argv[++i];
+    } else {
+      usage(argv[0]);
+      return 1;
+    }
+  }
+  if (samples == 0) {
+    usage(argv[0]);
+    return 1;
+  }
+
+  const float sampleRate = 44100.0f;
+  vector<Topology> topologies = {
+      {"rc_ladder", SyntheticCircuits::RCLadder},
+      {"diode_ladder", SyntheticCircuits::DiodeLadder},
+      {"common_emitter_cascade", SyntheticCircuits::CommonEmitterCascade},
+      {"random_mesh", [](int n) { return SyntheticCircuits::RandomMesh(n); }},
+  };
+  vector<Backend> backends = {
+      {"dense",
+       [](CircuitProcessor *proc, float sr) {
+         return [proc, sr, t = 0.0](size_t n, float **in,
+                                    float **out) mutable {
+           proc->getCircuit()->solveTransient(t, 1.0 / sr, n, proc->getInput(),
+                                              proc->getOutput(),
+                                              proc->getOutput(), in, out);
+           t += n / sr;
+         };
+       }},
+      {"relaxation",
+       [](CircuitProcessor *proc, float sr) {
+         WaveformRelaxationOptions options;
+         options.partitions = 4;
+         WorkerPool::instance().setThreads(options.partitions - 1);
+         auto solver = std::make_shared<WaveformRelaxationSolver>(
+             proc->getCircuit(), options);
+         return [proc, sr, solver, t = 0.0](size_t n, float **in,
+                                            float **out) mutable {
+           solver->solveTransient(t, 1.0 / sr, n, proc->getInput(),
+                                  proc->getOutput(), proc->getOutput(), in,
+                                  out);
+           t += n / sr;
+         };
+       }},
+  };
+
+  vector<float> input(samples), left(samples), right(samples);
+  for (size_t i = 0; i < samples; ++i) {
+    input[i] = 0.5f * sinf(2.0f * M_PI * 220.0f * i / sampleRate);
+  }
+  float *in[2] = {input.data(), input.data()};
+  float *out[2] = {left.data(), right.data()};
+
+  json report;
+  report["sampleRate"] = sampleRate;
+  report["samples"] = samples;
+  report["budgetMs"] = budgetMs;
+  report["results"] = json::array();
+
+  for (const auto &topology : topologies) {
+    for (const auto &backend : backends) {
+      for (int nodes : sizes) {
+        malloc_trim(0);
+        long rssBefore = residentBytes();
+
+        auto start = Clock::now();
+        CircuitProcessor *proc = topology.make(nodes);
+        double buildMs = msSince(start);
+
+        Circuit *circuit = proc->getCircuit();
+        int unknowns = circuit->getLastIndex();
+        auto solve = backend.make(proc, sampleRate);
+
+        // The first call carries the lazy setup (partitioning, sizing)
+        start = Clock::now();
+        solve(1, in, out);
+        double finalizeMs = msSince(start);
+
+        size_t iterations = circuit->getIterationCount();
+        start = Clock::now();
+        solve(samples, in, out);
+        double solveMs = msSince(start);
+        iterations = circuit->getIterationCount() - iterations;
+        long rss = residentBytes() - rssBefore;
+
+        json point = {
+            {"topology", topology.name},
+            {"backend", backend.name},
+            {"nodes", circuit->getNumStates()},
+            {"unknowns", unknowns},
+            {"components", circuit->getComponents().size()},
+            {"buildMs", buildMs},
+            {"finalizeMs", finalizeMs},
+            {"nsPerSample", solveMs * 1e6 / samples},
+            {"realTimeFactor", 1e3 / (solveMs / samples * sampleRate)},
+            {"rssBytes", rss},
+            {"matrixBytes", (long)unknowns * unknowns * sizeof(double)}};
+        if (backend.name == "dense") {
+          point["iterationsPerSample"] = (double)iterations / samples;
+        }
+        report["results"].push_back(point);
+        std::cerr << topology.name << " / " << backend.name << " / "
+                  << nodes << ": " << solveMs * 1e6 / samples << " ns/sample"
+                  << std::endl;
+
+        solve = nullptr;
+        delete proc;
+        if (solveMs / samples > budgetMs) {
+          break;
+        }
+      }
+    }
+  }
+
+  if (outputPath.empty()) {
+    std::cout << report.dump(2) << std::endl;
+  } else {
+    std::ofstream file(outputPath);
+    if (!file.is_open()) {
+      std::cerr << "Failed to open " << outputPath << std::endl;
+      return 1;
+    }
+    file << report.dump(2) << std::endl;
+  }
+  return 0;
+}